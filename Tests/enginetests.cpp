@@ -0,0 +1,373 @@
+#include "../compressedgraph.h"
+#include "../densegraph.h"
+#include "../dijkstra.h"
+#include "../flatgraph.h"
+#include "../floydwarshall.h"
+#include "../kshortestpaths.h"
+#include "../landmarks.h"
+#include "../queryclient.h"
+#include "../queryserver.h"
+#include "../reachability.h"
+#include "../shortestpath.h"
+#include "../utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+// Small checks of the graph engines, run by ctest. Each check prints what
+// went wrong and returns false.
+namespace {
+    bool expect(bool condition, const char *what) {
+        if (!condition) std::printf("  failed: %s\n", what);
+        return condition;
+    }
+
+    // Vertices 0..weights.size() joined by one edge per weight
+    void buildChain(GraphModel &model, const std::vector<qreal> &weights) {
+        for (size_t i = 0; i <= weights.size(); ++i) {
+            model.addVertex(i, {qreal(i), 0});
+        }
+        for (size_t i = 0; i < weights.size(); ++i) {
+            model.addEdge(i, i, i + 1, weights[i]);
+        }
+    }
+
+    template <typename Weight>
+    qreal chainLength(const GraphSnapshot &snapshot) {
+        FlatGraph<Weight> graph(snapshot);
+        PathTree<Weight> tree;
+        ShortestPath<FlatGraph<Weight>>::run(graph, graph.indexOf(0), tree);
+        return tree.distance[graph.indexOf(snapshot.vertexCount() - 1)];
+    }
+
+    // Float keeps 24 bits, so a large weight next to a half has to go to double
+    bool checkWeightSelection() {
+        bool isOk = true;
+
+        GraphModel mixed;
+        buildChain(mixed, {8388608, 0.5});
+        isOk &= expect(!FlatGraph<uint32_t>::canRepresent(*mixed.snapshot()), "halves are not integers");
+        isOk &= expect(!FlatGraph<float>::canRepresent(*mixed.snapshot()), "2^23 + 0.5 needs more than float");
+        isOk &= expect(chainLength<double>(*mixed.snapshot()) == 8388608.5, "double sums 2^23 + 0.5 exactly");
+
+        GraphModel halves;
+        buildChain(halves, {0.5, 1.25, 3.5, 100});
+        isOk &= expect(FlatGraph<float>::canRepresent(*halves.snapshot()), "small quarter steps fit float");
+        isOk &= expect(chainLength<float>(*halves.snapshot()) == 105.25, "float sums quarter steps exactly");
+
+        GraphModel integers;
+        buildChain(integers, {1, 99, 3});
+        isOk &= expect(FlatGraph<uint32_t>::canRepresent(*integers.snapshot()), "integer weights use uint32");
+        isOk &= expect(chainLength<uint32_t>(*integers.snapshot()) == 103, "Dial sums integers");
+
+        GraphModel tiny;
+        buildChain(tiny, {1.0 / 3});
+        isOk &= expect(!FlatGraph<float>::canRepresent(*tiny.snapshot()), "a third does not fit float");
+        return isOk;
+    }
+
+    // Sparse ids, gaps in the edge ids, repeated and one-off weights
+    void buildRandom(GraphModel &model, int vertexCount, int edgeCount, unsigned seed) {
+        std::mt19937 random(seed);
+        std::uniform_int_distribution<int> vertex(0, vertexCount - 1);
+        std::uniform_int_distribution<int> common(1, 5);
+        std::uniform_real_distribution<qreal> rare(0, 1000);
+
+        for (int id = 0; id < vertexCount; ++id) {
+            model.addVertex(id, {0, 0});
+        }
+        for (int id = 0; id < edgeCount; ++id) {
+            int from = vertex(random);
+            int to = vertex(random);
+            if (from != to) model.addEdge(id, from, to, id % 7 ? common(random) : rare(random));
+        }
+        for (int id = 0; id < vertexCount; id += 17) {
+            model.removeVertex(id);
+        }
+    }
+
+    bool isSameDistance(qreal first, qreal second) {
+        return first == second || std::abs(first - second) <= 1e-9 * std::max(std::abs(first), std::abs(second));
+    }
+
+    // Both directions of every pair joined with the given probability
+    void buildDense(GraphModel &model, int vertexCount, qreal density, unsigned seed) {
+        std::mt19937 random(seed);
+        std::uniform_real_distribution<qreal> unit(0, 1);
+        std::uniform_real_distribution<qreal> weight(1, 100);
+
+        for (int id = 0; id < vertexCount; ++id) {
+            model.addVertex(id, {0, 0});
+        }
+        int edgeId = 0;
+        for (int from = 0; from < vertexCount; ++from) {
+            for (int to = 0; to < vertexCount; ++to) {
+                if (from != to && unit(random) < density) model.addEdge(edgeId++, from, to, weight(random));
+            }
+        }
+    }
+
+    // Sizes off the vector width leave padding in every row; the smaller graph
+    // runs the animated dense search, the larger one the events-free engine
+    bool checkDenseEngine() {
+        bool isSame = true;
+        bool isDense = true;
+        for (int vertexCount : {203, int(Dijkstra::ANIMATION_LIMIT) + 3}) {
+            GraphModel model;
+            buildDense(model, vertexCount, 0.3, vertexCount);
+            std::shared_ptr<const GraphSnapshot> snapshot = model.snapshot();
+            isDense = isDense && DenseGraph::isDense(snapshot->vertexCount(), snapshot->edgeCount());
+
+            FlatGraph<double> graph(*snapshot);
+            PathTree<double> expected;
+            ShortestPath<FlatGraph<double>>::run(graph, graph.indexOf(5), expected);
+
+            std::unordered_map<int, qreal> distances;
+            for (const Event& event : Dijkstra::run(*snapshot, 5)) {
+                if (event.name == SET_WEIGHT) distances[event.vertexId] = event.weight;
+            }
+            for (int vertex = 0; vertex < graph.size(); ++vertex) {
+                auto found = distances.find(graph.idAt(vertex));
+                isSame = isSame && found != distances.end() && isSameDistance(found->second, expected.distance[vertex]);
+            }
+        }
+
+        bool isOk = expect(isDense, "both graphs count as dense");
+        isOk &= expect(isSame, "dense runs match the heap");
+        return isOk;
+    }
+
+    bool isSameAdjacency(const GraphSnapshot &snapshot) {
+        FlatGraph<double> flat(snapshot);
+        CompressedGraph<double> compressed(snapshot);
+        bool isOk = expect(flat.size() == compressed.size() && flat.edgeCount() == compressed.edgeCount(), "same size");
+        isOk &= expect(flat.getMaxWeight() == compressed.getMaxWeight(), "same heaviest weight");
+
+        typedef std::vector<std::tuple<int, double, int>> EdgeList;
+        bool isSame = true;
+        for (int vertex = 0; vertex < flat.size() && isOk; ++vertex) {
+            EdgeList expected, decoded;
+            flat.forEachOut(vertex, [&](int target, double weight, int edgeId) { expected.emplace_back(target, weight, edgeId); });
+            compressed.forEachOut(vertex, [&](int target, double weight, int edgeId) { decoded.emplace_back(target, weight, edgeId); });
+            std::sort(expected.begin(), expected.end());
+            std::sort(decoded.begin(), decoded.end());
+            isSame = isSame && compressed.idAt(vertex) == flat.idAt(vertex) && decoded == expected;
+        }
+        isOk &= expect(isSame, "every vertex decodes to its own out-edges");
+
+        PathTree<double> flatTree, compressedTree;
+        ShortestPath<FlatGraph<double>>::run(flat, flat.indexOf(1), flatTree);
+        ShortestPath<CompressedGraph<double>>::run(compressed, compressed.indexOf(1), compressedTree);
+        isOk &= expect(flatTree.distance == compressedTree.distance, "same distances from both forms");
+        return isOk;
+    }
+
+    // The chain has more distinct weights than the table holds
+    bool checkCompressedRoundTrip() {
+        GraphModel model;
+        buildRandom(model, 500, 4000, 1);
+        bool isOk = isSameAdjacency(*model.snapshot());
+
+        std::vector<qreal> weights(CompressedGraph<double>::MAX_WEIGHT_CODES * 2);
+        for (size_t i = 0; i < weights.size(); ++i) {
+            weights[i] = i % 4 ? i + 0.25 : 1;
+        }
+        GraphModel chain;
+        buildChain(chain, weights);
+        isOk &= isSameAdjacency(*chain.snapshot());
+        return isOk;
+    }
+
+    // A size off the tile width leaves partial tiles on the last row and column
+    bool checkFloydWarshall() {
+        GraphModel model;
+        buildRandom(model, 150, 900, 3);
+        std::shared_ptr<const GraphSnapshot> snapshot = model.snapshot();
+        DistanceMatrix matrix = FloydWarshall::run(*snapshot);
+
+        FlatGraph<double> graph(*snapshot);
+        bool isOk = expect(graph.size() % FloydWarshall::TILE != 0, "the last tiles are partial");
+
+        bool isSame = true;
+        for (int source = 0; source < graph.size(); ++source) {
+            PathTree<double> tree;
+            ShortestPath<FlatGraph<double>>::run(graph, source, tree);
+            for (int target = 0; target < graph.size(); ++target) {
+                qreal distance = matrix.distance(graph.idAt(source), graph.idAt(target));
+                if (tree.distance[target] == WeightTraits<double>::infinity()) isSame = isSame && distance == INF;
+                else isSame = isSame && isSameDistance(distance, tree.distance[target]);
+            }
+        }
+        isOk &= expect(isSame, "every pair matches a single-source run");
+        return isOk;
+    }
+
+    // Large enough for the parallel levels, and the middle levels of a random
+    // graph are wide enough to switch to bottom-up and back
+    bool checkReachability() {
+        GraphModel model;
+        buildRandom(model, 20000, 60000, 5);
+        std::shared_ptr<const GraphSnapshot> snapshot = model.snapshot();
+
+        std::vector<int> order;
+        snapshot->forEachVertex([&](const VertexRecord &vertex) { order.push_back(vertex.id); });
+        std::reverse(order.begin(), order.end());
+        Reachability reachability(*snapshot);
+        Reachability reordered(*snapshot, order);
+
+        bool isSame = true;
+        for (int startId = 1; startId < 20000; startId += 1999) {
+            std::vector<int> expected = Reachability::firstFrom(*snapshot, startId, snapshot->vertexCount());
+            std::vector<int> reached = reachability.from(startId);
+            std::vector<int> reachedReordered = reordered.from(startId);
+            std::sort(expected.begin(), expected.end());
+            std::sort(reached.begin(), reached.end());
+            std::sort(reachedReordered.begin(), reachedReordered.end());
+            isSame = isSame && reached == expected && reachedReordered == expected;
+        }
+        return expect(isSame, "same reachable sets as the serial search");
+    }
+
+    // Yen's own example: seven loopless routes from C to H, three of them
+    // tied at length 8
+    bool checkKShortestPaths() {
+        enum { C, D, E, F, G, H };
+        const std::tuple<int, int, qreal> EDGES[] = {
+            {C, D, 3}, {C, E, 2}, {D, F, 4}, {E, D, 1}, {E, F, 2},
+            {E, G, 3}, {F, G, 2}, {F, H, 1}, {G, H, 2},
+        };
+        GraphModel model;
+        for (int id = C; id <= H; ++id) {
+            model.addVertex(id, {qreal(id), 0});
+        }
+        int edgeId = 0;
+        for (const auto& [from, to, weight] : EDGES) {
+            model.addEdge(edgeId++, from, to, weight);
+        }
+        std::shared_ptr<const GraphSnapshot> snapshot = model.snapshot();
+
+        std::vector<Route> routes = KShortestPaths(*snapshot).find(C, H, 10);
+        std::vector<qreal> lengths;
+        for (const Route& route : routes) {
+            lengths.push_back(route.length);
+        }
+        bool isOk = expect(lengths == std::vector<qreal>({5, 7, 8, 8, 8, 11, 11}), "every route, shortest first");
+        isOk &= expect(!routes.empty() && routes[0].vertexIds == std::vector<int>({C, E, F, H}), "the shortest route first");
+
+        bool isValid = true;
+        for (const Route& route : routes) {
+            std::vector<int> visited = route.vertexIds;
+            std::sort(visited.begin(), visited.end());
+            isValid = isValid && std::adjacent_find(visited.begin(), visited.end()) == visited.end();
+            isValid = isValid && route.vertexIds.front() == C && route.vertexIds.back() == H;
+            isValid = isValid && route.edgeIds.size() + 1 == route.vertexIds.size();
+
+            qreal length = 0;
+            for (size_t i = 0; i < route.edgeIds.size() && isValid; ++i) {
+                const EdgeRecord *edge = snapshot->edge(route.edgeIds[i]);
+                isValid = edge->startId == route.vertexIds[i] && edge->endId == route.vertexIds[i + 1];
+                length += edge->weight;
+            }
+            isValid = isValid && length == route.length;
+        }
+        isOk &= expect(isValid, "loopless routes along their own edges");
+
+        std::vector<std::vector<int>> distinct;
+        for (const Route& route : routes) {
+            distinct.push_back(route.vertexIds);
+        }
+        std::sort(distinct.begin(), distinct.end());
+        isOk &= expect(std::unique(distinct.begin(), distinct.end()) == distinct.end(), "no route twice");
+        return isOk;
+    }
+
+    // Stamps from before the epoch wrapped must not count as reached, and a
+    // much smaller graph gets fresh arrays
+    bool checkWorkspaceReuse() {
+        GraphModel model;
+        buildChain(model, std::vector<qreal>(300, 0.5));
+        std::shared_ptr<const GraphSnapshot> snapshot = model.snapshot();
+        FlatGraph<qreal> graph(*snapshot);
+        const int middle = 150;
+        PathTree<qreal> expected;
+        ShortestPath<FlatGraph<qreal>>::run(graph, graph.indexOf(middle), expected);
+
+        Landmarks landmarks;
+        landmarks.build(*snapshot, {});
+
+        QueryWorkspace<qreal>::local(100000);
+        bool isOk = expect(QueryWorkspace<qreal>::local(graph.size()).reached.size() == size_t(graph.size()), "arrays shrink to the graph");
+
+        // A run from vertex i stamps only the chain from i on, so vertex i
+        // keeps the stamp i + 1 that the epoch comes back to after the wrap
+        QueryWorkspace<qreal>::local(graph.size()).epoch = 0;
+        for (int first = 0; first < 20; ++first) {
+            ShortestPath<FlatGraph<qreal>>::run(graph, graph.indexOf(first));
+        }
+        QueryWorkspace<qreal>::local(graph.size()).epoch = UINT32_MAX - 3;
+
+        bool isSame = true;
+        for (int run = 0; run < 8; ++run) {
+            QueryWorkspace<qreal>& tree = ShortestPath<FlatGraph<qreal>>::run(graph, graph.indexOf(middle));
+            for (int vertex = 0; vertex < graph.size(); ++vertex) {
+                isSame = isSame && tree.distanceTo(vertex) == expected.distance[vertex];
+            }
+
+            Route route;
+            size_t settled;
+            int target = middle + 10 * run;
+            isSame = isSame && landmarks.query(middle, target, route, settled) && route.length == expected.distance[graph.indexOf(target)];
+        }
+        isOk &= expect(isSame, "same distances before and after the epoch wraps");
+        isOk &= expect(QueryWorkspace<qreal>::local(graph.size()).epoch < UINT32_MAX - 3, "the epoch wrapped");
+        return isOk;
+    }
+
+    // Three times what the server queues, so answers have to flow while the
+    // client is still sending
+    bool checkServerRoundTrip() {
+        GraphModel model;
+        buildChain(model, std::vector<qreal>(2000, 1));
+
+        const std::string path = "enginetests.sock";
+        std::string error;
+        QueryServer server;
+        if (!expect(server.start(path, error), "server starts")) return false;
+        server.setGraph(model.snapshot());
+
+        bool isOk = expect(QueryClient::run(path, 0, int(QueryServer::MAX_QUEUED) * 3) == 0, "every answer matches");
+        server.stop();
+        return isOk;
+    }
+
+    struct Check {
+        const char *name;
+        bool (*function)();
+    };
+
+    const Check CHECKS[] = {
+        {"weight type selection", checkWeightSelection},
+        {"compressed adjacency round trip", checkCompressedRoundTrip},
+        {"dense kernels", checkDenseEngine},
+        {"blocked Floyd-Warshall", checkFloydWarshall},
+        {"direction-optimizing reachability", checkReachability},
+        {"k shortest paths", checkKShortestPaths},
+        {"query workspace reuse", checkWorkspaceReuse},
+        {"query server round trip", checkServerRoundTrip},
+    };
+}
+
+int main() {
+    int failures = 0;
+    for (const Check& check : CHECKS) {
+        bool isOk = check.function();
+        std::printf("%s %s\n", isOk ? "ok    " : "FAILED", check.name);
+        if (!isOk) ++failures;
+    }
+    return failures;
+}
@@ -0,0 +1,243 @@
+#include "benchmark.h"
+#include "canvas.h"
+#include "compressedgraph.h"
+#include "graphtransaction.h"
+#include "reachability.h"
+#include "shortestpath.h"
+#include "vertexorder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+#include <QElapsedTimer>
+
+void Benchmark::buildGraph(Canvas &canvas, int vertexCount, QPointF &min, QPointF &max) {
+    std::mt19937 random(SEED);
+    std::uniform_real_distribution<qreal> jitter(-30, 30);
+    std::uniform_int_distribution<int> weight(1, 99);
+
+    const int columns = std::ceil(std::sqrt(qreal(vertexCount)));
+    const qreal gap = 150;
+
+    GraphTransaction transaction(&canvas);
+    std::vector<int> ids;
+    ids.reserve(vertexCount);
+
+    for (int i = 0; i < vertexCount; ++i) {
+        QPointF pos = {(i % columns) * gap + jitter(random), (i / columns) * gap + jitter(random)};
+        ids.push_back(transaction.addVertex(pos));
+
+        if (i == 0) min = max = pos;
+        min = {std::min(min.x(), pos.x()), std::min(min.y(), pos.y())};
+        max = {std::max(max.x(), pos.x()), std::max(max.y(), pos.y())};
+    }
+
+    // Right and down neighbours, plus a few one-way diagonals
+    for (int i = 0; i < vertexCount; ++i) {
+        if ((i + 1) % columns && i + 1 < vertexCount) transaction.addEdge(ids[i], ids[i + 1], weight(random));
+        if (i + columns < vertexCount) transaction.addEdge(ids[i + columns], ids[i], weight(random));
+        if (i % 3 == 0 && (i + 1) % columns && i + columns + 1 < vertexCount) {
+            transaction.addEdge(ids[i], ids[i + columns + 1], weight(random));
+        }
+    }
+
+    transaction.commit();
+}
+
+std::vector<Benchmark::View> Benchmark::scriptViews(const QPointF &min, const QPointF &max) {
+    QPointF center = (min + max) / 2;
+    qreal fit = std::min(WIDTH / (max.x() - min.x() + 100), HEIGHT / (max.y() - min.y() + 100));
+
+    std::vector<View> views = {
+        {"overview", center, std::max(0.25, std::min(1.0, fit))},
+        {"zoom-1x", center, 1.0},
+        {"zoom-2x", center, 2.0},
+        {"corner", min + QPointF{WIDTH / 2.0, HEIGHT / 2.0}, 1.0},
+    };
+
+    // A horizontal pan across the graph at the default zoom
+    for (int step = 0; step < 4; ++step) {
+        qreal x = min.x() + (max.x() - min.x()) * step / 3;
+        views.push_back({"pan", {x, center.y()}, 1.0});
+    }
+
+    return views;
+}
+
+uint64_t Benchmark::checksum(const QImage &image) {
+    // FNV-1a over the visible bytes of every scanline
+    uint64_t hash = 14695981039346656037ull;
+    const int rowBytes = image.width() * 4;
+
+    for (int y = 0; y < image.height(); ++y) {
+        const uchar *line = image.constScanLine(y);
+        for (int i = 0; i < rowBytes; ++i) {
+            hash = (hash ^ line[i]) * 1099511628211ull;
+        }
+    }
+
+    return hash;
+}
+
+void Benchmark::measure(Canvas &canvas, QImage &image, const View &view) {
+    canvas.scaleFactor = view.scaleFactor;
+    canvas.offset = QPointF{WIDTH / 2.0, HEIGHT / 2.0} - view.sceneCenter * view.scaleFactor;
+
+    std::vector<qreal> times;
+    uint64_t firstChecksum = 0;
+    bool isStable = true;
+
+    for (int frame = 0; frame < WARMUP_FRAMES + FRAMES; ++frame) {
+        image.fill(Qt::white);
+
+        QElapsedTimer timer;
+        timer.start();
+        canvas.render(&image);
+        qreal ms = timer.nsecsElapsed() / 1e6;
+
+        if (frame < WARMUP_FRAMES) continue;
+
+        uint64_t hash = checksum(image);
+        if (times.empty()) firstChecksum = hash;
+        else if (hash != firstChecksum) isStable = false;
+
+        times.push_back(ms);
+    }
+
+    qreal total = 0;
+    for (qreal ms : times) {
+        total += ms;
+    }
+    std::sort(times.begin(), times.end());
+
+    std::printf("%zu,%zu,%s,%.3f,%s,%zu,%.3f,%.3f,%.3f,%016llx,%s\n",
+                canvas.vertices.size(), canvas.edges.size(), view.name, view.scaleFactor,
+                canvas.isTiledRendering ? "tiled" : "direct", times.size(),
+                total / times.size(), times[times.size() / 2], times.back(),
+                (unsigned long long)firstChecksum, isStable ? "yes" : "no");
+    std::fflush(stdout);
+}
+
+// The jittered grid of buildGraph with edges pointing right and down, so the
+// top-left vertex reaches everything, and ids handed out in random order.
+// Returns the id of the top-left vertex.
+int Benchmark::buildModel(GraphModel &model, int vertexCount) {
+    std::mt19937 random(SEED);
+    std::uniform_real_distribution<qreal> jitter(-30, 30);
+    std::uniform_int_distribution<int> weight(1, 99);
+
+    const int columns = std::ceil(std::sqrt(qreal(vertexCount)));
+    const qreal gap = 150;
+
+    std::vector<int> ids(vertexCount);
+    for (int i = 0; i < vertexCount; ++i) {
+        ids[i] = i;
+    }
+    std::shuffle(ids.begin(), ids.end(), random);
+
+    for (int i = 0; i < vertexCount; ++i) {
+        model.addVertex(i, {0, 0});
+    }
+    for (int i = 0; i < vertexCount; ++i) {
+        model.moveVertex(ids[i], {(i % columns) * gap + jitter(random), (i / columns) * gap + jitter(random)});
+    }
+
+    int edgeId = 0;
+    for (int i = 0; i < vertexCount; ++i) {
+        if ((i + 1) % columns && i + 1 < vertexCount) model.addEdge(edgeId++, ids[i], ids[i + 1], weight(random));
+        if (i + columns < vertexCount) model.addEdge(edgeId++, ids[i], ids[i + columns], weight(random));
+        if (i % 3 == 0 && (i + 1) % columns && i + columns + 1 < vertexCount) {
+            model.addEdge(edgeId++, ids[i + columns + 1], ids[i], weight(random));
+        }
+    }
+
+    return ids[0];
+}
+
+int Benchmark::runPaths() {
+    const int sizes[] = {50000, 500000};
+    const VertexOrder::Method methods[] = {VertexOrder::SNAPSHOT, VertexOrder::CUTHILL_MCKEE, VertexOrder::HILBERT};
+
+    std::printf("vertices,edges,order,order_ms,build_ms,bfs_ms,sssp_ms,flat_bytes,"
+                "compressed_build_ms,compressed_sssp_ms,compressed_bytes,reached\n");
+
+    for (int vertexCount : sizes) {
+        GraphModel model;
+        int sourceId = buildModel(model, vertexCount);
+        std::shared_ptr<const GraphSnapshot> snapshot = model.snapshot();
+
+        for (VertexOrder::Method method : methods) {
+            QElapsedTimer timer;
+            timer.start();
+            std::vector<int> order = VertexOrder::compute(*snapshot, method);
+            qreal orderMs = timer.nsecsElapsed() / 1e6;
+
+            timer.restart();
+            FlatGraph<uint32_t> graph(*snapshot, order);
+            Reachability reachability(*snapshot, order);
+            qreal buildMs = timer.nsecsElapsed() / 1e6;
+
+            timer.restart();
+            CompressedGraph<uint32_t> compressed(*snapshot, order);
+            qreal compressedBuildMs = timer.nsecsElapsed() / 1e6;
+
+            std::vector<qreal> bfsTimes, ssspTimes, compressedTimes;
+            size_t reached = 0;
+
+            for (int repeat = 0; repeat < PATH_REPEATS; ++repeat) {
+                timer.restart();
+                reached = reachability.from(sourceId).size();
+                bfsTimes.push_back(timer.nsecsElapsed() / 1e6);
+
+                PathTree<uint32_t> tree;
+                timer.restart();
+                ShortestPath<FlatGraph<uint32_t>>::run(graph, graph.indexOf(sourceId), tree);
+                ssspTimes.push_back(timer.nsecsElapsed() / 1e6);
+
+                timer.restart();
+                ShortestPath<CompressedGraph<uint32_t>>::run(compressed, compressed.indexOf(sourceId), tree);
+                compressedTimes.push_back(timer.nsecsElapsed() / 1e6);
+            }
+
+            std::sort(bfsTimes.begin(), bfsTimes.end());
+            std::sort(ssspTimes.begin(), ssspTimes.end());
+            std::sort(compressedTimes.begin(), compressedTimes.end());
+
+            std::printf("%d,%zu,%s,%.3f,%.3f,%.3f,%.3f,%zu,%.3f,%.3f,%zu,%zu\n",
+                        vertexCount, snapshot->edgeCount(), VertexOrder::name(method), orderMs, buildMs,
+                        bfsTimes[PATH_REPEATS / 2], ssspTimes[PATH_REPEATS / 2], graph.memoryUsage(),
+                        compressedBuildMs, compressedTimes[PATH_REPEATS / 2], compressed.memoryUsage(), reached);
+            std::fflush(stdout);
+        }
+    }
+
+    return 0;
+}
+
+int Benchmark::run() {
+    const int sizes[] = {100, 1000, 5000, 20000};
+
+    std::printf("vertices,edges,view,scale,renderer,frames,mean_ms,p50_ms,max_ms,checksum,stable\n");
+
+    for (int vertexCount : sizes) {
+        Canvas canvas;
+        canvas.resize(WIDTH, HEIGHT);
+
+        QPointF min, max;
+        buildGraph(canvas, vertexCount, min, max);
+
+        QImage image(WIDTH, HEIGHT, QImage::Format_ARGB32_Premultiplied);
+
+        for (const View &view : scriptViews(min, max)) {
+            canvas.isTiledRendering = false;
+            measure(canvas, image, view);
+
+            canvas.isTiledRendering = true;
+            measure(canvas, image, view);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,47 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <cstdint>
+#include <vector>
+
+#include <QImage>
+#include <QPointF>
+
+class Canvas;
+class GraphModel;
+
+// Headless paint benchmark, started with "--bench". Builds synthetic graphs
+// of increasing size, renders the canvas into an image at scripted pan/zoom
+// positions with the direct and the tiled renderer, and prints frame times
+// with a checksum of the rendered pixels.
+//
+// "--bench-paths" times BFS and shortest paths on large grids whose ids are
+// shuffled like an import that ignores the layout, once per VertexOrder.
+class Benchmark {
+
+public:
+    static int run();
+    static int runPaths();
+
+    static constexpr int WIDTH = 1280;
+    static constexpr int HEIGHT = 800;
+    static constexpr int WARMUP_FRAMES = 2;
+    static constexpr int FRAMES = 20;
+    static constexpr int SEED = 42;
+    static constexpr int PATH_REPEATS = 5;
+
+private:
+    struct View {
+        const char *name;
+        QPointF sceneCenter;
+        qreal scaleFactor;
+    };
+
+    static void buildGraph(Canvas &canvas, int vertexCount, QPointF &min, QPointF &max);
+    static int buildModel(GraphModel &model, int vertexCount);
+    static std::vector<View> scriptViews(const QPointF &min, const QPointF &max);
+    static void measure(Canvas &canvas, QImage &image, const View &view);
+    static uint64_t checksum(const QImage &image);
+};
+
+#endif // BENCHMARK_H
@@ -1,613 +1,1471 @@
-#include "utils.h"
-#include "canvas.h"
-#include "dijkstra.h"
-
-#include <unordered_map>
-#include <algorithm>
-
-#include <QMouseEvent>
-#include <QPainter>
-#include <QKeyEvent>
-#include <QFontMetrics>
-#include <QPainterPath>
-#include <QEventLoop>
-#include <QTimer>
-
-Canvas::Canvas(QWidget *parent) : QMainWindow(parent) {
-    setFocusPolicy(Qt::StrongFocus);
-    setMouseTracking(true);
-    setFocus();
-}
-
-void delay(int milliseconds) {
-    QEventLoop loop;
-    QTimer::singleShot(milliseconds, &loop, &QEventLoop::quit);
-    loop.exec();
-}
-
-QPointF Canvas::getTransformedPos(const QPointF& pos) {
-    QTransform transform;
-    transform.translate(offset.x(), offset.y());
-    transform.scale(scaleFactor, scaleFactor);
-    return transform.inverted().map(pos);
-}
-
-int Canvas::getNumFromArray(std::vector<int> array) {
-    int num = 0;
-    int i = array.size();
-    for (int digit : array) {
-        num += digit * pow(10, i - 1);
-        --i;
-    }
-    return num;
-}
-
-QPointF Canvas::getAbsoluteCenter() {
-    QSize windowSize = this->size();
-    return {windowSize.rwidth() / 2.0f, windowSize.rheight() / 2.0f};
-}
-
-Vertex* Canvas::getClickedVertex(QPointF clickPos) {
-    Vertex* clickedVertex = nullptr;
-    for (const auto& [id, vertex] : vertices) {
-        bool isInRadius = QLineF(clickPos, vertex->pos).length() <= vertex->radius;
-        if (!isInRadius) continue;
-
-        clickedVertex = vertex;
-    }
-    return clickedVertex;
-}
-
-void getSubGraphVertices(const Vertex &startVertex, const vertexMap &vertices, vertexMap &subGraph) {
-    subGraph.insert({startVertex.id, vertices.at(startVertex.id)});
-
-    for (int id : startVertex.out.vertexId) {
-        if (subGraph.find(id) == subGraph.end()) {
-            Vertex *vertex = vertices.at(id);
-            getSubGraphVertices(*vertex, vertices, subGraph);
-        }
-    }
-}
-
-void Canvas::resetInputState() {
-    intPressed1.clear();
-    intPressed2.clear();
-    isFirstLink = true;
-    floatExponent1 = 0;
-    floatExponent2 = 0;
-}
-
-void Canvas::selectVertex(int id) {
-    vertices.at(id)->isSelected = true;
-    selectedVertices.push_back(id);
-}
-
-void Canvas::deselectFirstVertex() {
-    vertices.at(selectedVertices[0])->isSelected = false;
-    selectedVertices.erase(selectedVertices.begin());
-}
-
-void Canvas::deselectAllVertices() {
-    for (int id : selectedVertices) {
-        vertices.at(id)->isSelected = false;
-    }
-    selectedVertices.clear();
-}
-
-void Canvas::createVertex(QPointF pos, int radius) {
-    QString name = QString::number(totalVertices);
-    vertices.insert({totalVertices, new Vertex(name, totalVertices, radius, pos, this)});
-
-    if (selectedVertices.size() > 2) {
-        deselectAllVertices();
-    }
-    else if (selectedVertices.size() == 2) {
-        deselectFirstVertex();
-    }
-
-    selectVertex(totalVertices);
-    ++totalVertices;
-
-    update();
-}
-
-void Canvas::linkVertices(int firstId, int secondId, qreal weight) {
-    if (utils::contains(vertices.at(firstId)->out.vertexId, secondId) || firstId == secondId) return;
-
-    vertices.at(secondId)->in.vertexId.push_back(firstId);
-    vertices.at(secondId)->in.edgeId.push_back(totalEdges);
-    vertices.at(firstId)->out.vertexId.push_back(secondId);
-    vertices.at(firstId)->out.edgeId.push_back(totalEdges);
-
-    edges.insert({totalEdges, new Edge(QString::number(weight), totalEdges, firstId, secondId, weight)});
-
-    ++totalEdges;
-
-    update();
-}
-
-void Canvas::drawVertices(QPainter& painter) {
-    painter.setBrush(Qt::white);
-    painter.setPen(Qt::black);
-
-    for (const auto& [id, vertex] : vertices) {
-        vertex->draw(this, painter);
-    }
-}
-
-void Canvas::drawEdges(QPainter& painter) {
-    painter.setBrush(Qt::black);
-
-    for (const auto& [id, edge] : edges) {
-        bool betweenSelected = vertices.at(edge->startId)->isSelected && vertices.at(edge->endId)->isSelected;
-        bool isBoth = betweenSelected && intPressed1.size() > 0;
-        edge->draw(this, painter, isBoth);
-    }
-}
-
-void Canvas::drawFakeEdges(QPainter& painter) {
-    if (intPressed1.size() <= 0) return;
-
-    fakeEdge->startId = selectedVertices[isShiftPressed];
-    fakeEdge->endId = selectedVertices[!isShiftPressed];
-    if (!utils::contains(vertices.at(fakeEdge->startId)->out.vertexId, fakeEdge->endId)) {
-        painter.setBrush(Qt::green);
-        painter.setPen(Qt::green);
-        painter.setOpacity(0.3);
-
-        qreal weight = getNumFromArray(intPressed1) / (floatExponent1 ? floatExponent1 : 1.f);
-        fakeEdge->displayText = QString::number(weight) + (floatExponent1 == 1 && isFirstLink ? "." : "");
-        fakeEdge->draw(this, painter, !isFirstLink);
-    }
-
-    if (isFirstLink) return;
-
-    fakeEdge->startId = selectedVertices[!isShiftPressed];
-    fakeEdge->endId = selectedVertices[isShiftPressed];
-
-    if (utils::contains(vertices.at(fakeEdge->startId)->out.vertexId, fakeEdge->endId)) return;
-
-    if (intPressed2.size() <= 0) {
-        fakeEdge->weight = -1;
-        fakeEdge->displayText = "";
-    }
-    else {
-        qreal weight = getNumFromArray(intPressed2)  / (floatExponent2 ? floatExponent2 : 1.f);
-        fakeEdge->displayText = QString::number(weight) + (floatExponent2 == 1 ? "." : "");
-    }
-
-    fakeEdge->draw(this, painter, true);
-}
-
-void Canvas::drawGrid(QPainter& painter, const QPointF& center) {
-    const qreal xCenterOffset = center.x() / scaleFactor;
-    const qreal yCenterOffset = center.y() / scaleFactor;
-
-    const qreal leftBorder   = screenCenter.x() - xCenterOffset;
-    const qreal rightBorder  = screenCenter.x() + xCenterOffset;
-    const qreal topBorder    = screenCenter.y() - yCenterOffset;
-    const qreal bottomBorder = screenCenter.y() + yCenterOffset;
-
-    const qreal gap = scaleFactor > 0.8 ? GRID_GAP : GRID_GAP * GRID_DIVISON;
-    const int actualDivision = scaleFactor > 0.8 ? GRID_DIVISON : 1;
-
-    const int left   = utils::absCeil((leftBorder - LINE_THICKNESS) / gap);
-    const int right  = utils::absCeil((rightBorder + LINE_THICKNESS) / gap);
-    const int top    = utils::absCeil((topBorder - LINE_THICKNESS) / gap);
-    const int bottom = utils::absCeil((bottomBorder + LINE_THICKNESS) / gap);
-
-    QColor gridColor = QColor(gridLightnes, gridLightnes, gridLightnes, 255);
-    for (int i = left; i <= right; ++i) {
-        painter.setPen(QPen(gridColor, 0.1f));
-
-        if (i == 0) painter.setPen(QPen(QColor(gridLightnes - 50, gridLightnes - 50, gridLightnes - 50, 255), 1));
-        else if (i % actualDivision * actualDivision == 0) painter.setPen(QPen(gridColor, 0.5f));
-        else if (i % actualDivision == 0) painter.setPen(QPen(gridColor, 0.3f));
-
-        painter.drawLine(QLineF({gap * i, bottomBorder},
-                                {gap * i, topBorder}));
-    }
-
-    for (int i = top; i <= bottom; ++i) {
-        painter.setPen(QPen(gridColor, 0.1f));
-
-        if (i == 0) painter.setPen(QPen(QColor(gridLightnes - 50, gridLightnes - 50, gridLightnes - 50, 255), 1));
-        else if (i % actualDivision * actualDivision == 0) painter.setPen(QPen(gridColor, 0.5f));
-        else if (i % actualDivision == 0) painter.setPen(QPen(gridColor, 0.3f));
-
-        painter.drawLine(QLineF({rightBorder , gap * i},
-                                {leftBorder , gap * i}));
-    }
-
-    painter.setPen(QPen(Qt::black, 1));
-}
-
-void Canvas::drawTutorial(QPainter& painter) {
-    const int startY = 5;
-    const int lineHeight = 18;
-    const int textPaddingX = 6;
-    const int textPaddingY = 18;
-    const int rectOffsetY = 14;
-    const int textOffsetX = 13;
-
-    int y = startY;
-
-    for (const QString& line : tutorialText) {
-        y += lineHeight;
-
-        int textWidth = painter.fontMetrics().horizontalAdvance(line);
-        QRect textRect(10, y - rectOffsetY, textWidth + textPaddingX, lineHeight);
-        painter.fillRect(textRect, Qt::white);
-
-        painter.drawText(textOffsetX, y, line);
-    }
-}
-
-void Canvas::paintEvent(QPaintEvent *event) {
-    QPainter painter(this);
-    painter.setRenderHint(QPainter::Antialiasing);
-    painter.setFont(textFont);
-    painter.translate(offset);
-    painter.scale(scaleFactor, scaleFactor);
-
-    QPointF center = getAbsoluteCenter();
-    screenCenter = (center - offset) / scaleFactor;
-    halfScreenDiagonal = qSqrt(QPointF::dotProduct(center, center)) / scaleFactor;
-
-    drawGrid(painter, center);
-    drawTutorial(painter);
-
-    painter.setFont(font);
-
-    drawEdges(painter);
-    drawFakeEdges(painter);
-    drawVertices(painter);
-}
-
-void Canvas::deleteEdge(int id) {
-    Edge *edge = edges.at(id);
-    Vertex *start = vertices.at(edge->startId);
-    Vertex *end = vertices.at(edge->endId);
-
-    utils::removeFromBothByFirst(start->out.edgeId, start->out.vertexId, id);
-    utils::removeFromBothByFirst(end->in.edgeId, end->in.vertexId, id);
-
-    delete edge;
-    edges.erase(id);
-}
-
-void Canvas::deleteVertex(int id) {
-    Vertex* vertex = vertices.at(id);
-    std::vector<int> inEdges = vertex->in.edgeId;
-    std::vector<int> outEdges = vertex->out.edgeId;
-
-    for (int edgeId : inEdges) {
-        deleteEdge(edgeId);
-    }
-    for (int edgeId : outEdges) {
-        deleteEdge(edgeId);
-    }
-
-    delete vertex;
-    vertices.erase(id);
-}
-
-void Canvas::cancelDijkstra() {
-    for (const auto& [id, vertex] : vertices) {
-        vertex->weight = -2;
-    }
-
-    ++iteretion;
-    isDijkstraRunning = false;
-    djCheckedVertices.clear();
-    djCheckedEdges.clear();
-    djEndAnimation.clear();
-    djStartVertex = -1;
-    djEndVertex = -1;
-    djCurrentVertex = -1;
-
-    update();
-}
-
-void Canvas::visualizeDijkstra(const vertexMap &graphVertices, const Events &events, int startIteretion) {
-    for (Event event : events) {
-        if (startIteretion != iteretion) break;
-
-        if (event.name == SET_START_VERTEX) {
-            djStartVertex = event.vertexId;
-            delay(START_DELAY_MS);
-        }
-        else if (event.name == SET_CURRENT_VERTEX) {
-            djCurrentVertex = event.vertexId;
-            delay(STEP_DELAY_MS);
-            update();
-            delay(STEP_DELAY_MS);
-        }
-        else if (event.name == SET_END_VERTEX) {
-            djEndVertex = event.vertexId;
-        }
-        else if (event.name == CHECK_VERTEX) {
-            djCheckedVertices.push_back(event.vertexId);
-            delay(STEP_DELAY_MS);
-        }
-        else if (event.name == CHECK_EDGE) {
-            djCheckedEdges.push_back(event.edgeId);
-        }
-        else if (event.name == UNCHECK_VERTEX) {
-            djCheckedVertices.erase(std::remove(djCheckedVertices.begin(), djCheckedVertices.end(), event.vertexId), djCheckedVertices.end());
-        }
-        else if (event.name == UNCHECK_EDGE) {
-            djCheckedEdges.erase(std::remove(djCheckedEdges.begin(), djCheckedEdges.end(), event.edgeId), djCheckedEdges.end());
-            delay(EDGE_STEP_DELAY_MS);
-        }
-        else if (event.name == SET_WEIGHT) {
-            vertices.at(event.vertexId)->weight = event.weight;
-        }
-
-        update();
-    }
-
-    for (const auto& vertex : graphVertices) {
-        if (startIteretion != iteretion) break;
-
-        delay(END_DELAY_MS);
-        djEndAnimation.insert(vertex);
-        update();
-    }
-
-    for (int i = 0; i < 3; ++i) {
-        if (startIteretion != iteretion) break;
-
-        delay(FLICK_DELAY_MS);
-        djEndAnimation = graphVertices;
-        update();
-
-        delay(FLICK_DELAY_MS);
-        djEndAnimation.clear();
-        update();
-    }
-}
-
-void Canvas::wheelEvent(QWheelEvent *event) {
-    QPointF cursorPos = event->position();
-    QPointF scenePos = (cursorPos - offset) / scaleFactor;
-
-    qreal factor = (event->angleDelta().y() > 0) ? 1.2 : 0.8;
-    if (scaleFactor > ZOOM_OUT_LIMIT || factor > 1) {
-        scaleFactor *= factor;
-    }
-
-    offset = cursorPos - scenePos * scaleFactor;
-
-    update();
-}
-
-void Canvas::mousePressEvent(QMouseEvent *event) {
-    if (event->button() == Qt::LeftButton) {
-        resetInputState();
-
-        currentTool->onLeftClick(event);
-    }
-
-    if (event->button() == Qt::MiddleButton) {
-        lastMousePos = event->pos();
-        this->setCursor(PAN_CURSOR);
-    }
-}
-
-void Canvas::mouseMoveEvent(QMouseEvent *event) {
-    if (draggingVertex && (event->buttons() & Qt::LeftButton)) {
-        QPointF transformedPos = getTransformedPos(event->pos());
-        QPointF mainVertPos = draggingVertex->pos;
-
-        for (int id : selectedVertices) {
-            QPointF vertOffset = mainVertPos - vertices.at(id)->pos;
-            vertices.at(id)->pos = transformedPos + draggingOffset - vertOffset;
-        }
-
-        update();
-    }
-
-    if (event->buttons() & Qt::MiddleButton) {
-        QPoint delta = event->pos() - lastMousePos;
-        lastMousePos = event->pos();
-        offset += delta;
-        update();
-    }
-}
-
-void Canvas::mouseReleaseEvent(QMouseEvent *event) {
-    draggingVertex = nullptr;
-    draggingOffset = {0, 0};
-    this->setCursor(currentTool->getCursor());
-}
-
-void Canvas::keyPressEvent(QKeyEvent *event) {
-    int key = event->key();
-
-    if (key == Qt::Key_Return || key == Qt::Key_E) {
-        if (!intPressed1.size()) return;
-        if (selectedVertices.size() != 2) return;
-
-        linkVertices(selectedVertices[isShiftPressed], selectedVertices[!isShiftPressed], getNumFromArray(intPressed1) / (floatExponent1 ? floatExponent1 : 1.f));
-        if (intPressed2.size()) linkVertices(selectedVertices[!isShiftPressed], selectedVertices[isShiftPressed], getNumFromArray(intPressed2) / (floatExponent2 ? floatExponent2 : 1.f));
-
-        selectedEdges.clear();
-        deselectFirstVertex();
-
-        resetInputState();
-        update();
-        return;
-    }
-
-    if (key >= '0' && key <= '9') {
-        if (selectedVertices.size() != 2) return;
-        if (utils::contains(vertices.at(selectedVertices[0])->out.vertexId, selectedVertices[1])) return;
-        if (isDijkstraRunning) return;
-
-        if (isFirstLink) {
-            if (intPressed1.size() == 0 && key == 0 ) return;
-            if (intPressed1.size() == 6) return;
-
-            intPressed1.push_back(key - '0');
-            if (floatExponent1) floatExponent1 *= 10;
-        }
-        else {
-            if (utils::contains(vertices.at(selectedVertices[1])->out.vertexId, selectedVertices[0])) return;
-            if (intPressed2.size() == 0 && key == 0 ) return;
-            if (intPressed2.size() == 6) return;
-
-            intPressed2.push_back(key - '0');
-            if (floatExponent2) floatExponent2 *= 10;
-        }
-
-        update();
-        return;
-    }
-
-    if (key == '.' || key == ',') {
-        if (!intPressed1.size()) return;
-        if (isFirstLink) {
-            if (!floatExponent1) floatExponent1 = 1;
-        }
-        else {
-            if (!floatExponent2) floatExponent2 = 1;
-        }
-
-        update();
-        return;
-    }
-
-    if (key == Qt::Key_Space) {
-        if (!intPressed1.size()) return;
-        isFirstLink = false;
-
-        update();
-        return;
-    }
-
-    if (key == Qt::Key_Backspace) {
-        if (!intPressed1.size()) return;
-
-        if (isFirstLink) {
-            intPressed1.pop_back();
-            if (floatExponent1) floatExponent1 /= 10;
-        }
-        else {
-            if (!intPressed2.size()) {
-                floatExponent2 = 0;
-                isFirstLink = true;
-                update();
-                return;
-            }
-            intPressed2.pop_back();
-            if (!intPressed2.size()) {
-                floatExponent2 = 0;
-            }
-            else if (floatExponent2) {
-                floatExponent2 /= 10;
-            }
-        }
-
-        update();
-        return;
-    }
-
-    if (key == Qt::Key_V) {
-        currentTool = selectTool;
-        this->setCursor(currentTool->getCursor());
-        return;
-    }
-
-    if (key == Qt::Key_B) {
-        currentTool = penTool;
-        this->setCursor(currentTool->getCursor());
-        return;
-    }
-
-    if (key == Qt::Key_F) {
-        cancelDijkstra();
-
-        if (selectedVertices.size() != 1) return;
-
-        selectedEdges.clear();
-        deselectAllVertices();
-        isDijkstraRunning = true;
-        int startIteretion = iteretion;
-
-        Vertex *startVertex = vertices.at(selectedVertices[0]);
-        vertexMap subGraphVertices;
-        getSubGraphVertices(*startVertex, vertices, subGraphVertices);
-        Events events = Dijkstra::run(*startVertex, subGraphVertices, edges);
-
-        visualizeDijkstra(subGraphVertices, events, startIteretion);
-
-        isDijkstraRunning = false;
-        resetInputState();
-        return;
-    }
-
-    if (key == Qt::Key_D) {
-        deselectAllVertices();
-
-        resetInputState();
-        update();
-        return;
-    }
-
-    if (key == Qt::Key_A) {
-        deselectAllVertices();
-
-        for (auto& [id, vertex] : vertices) {
-            selectVertex(id);
-        }
-
-        update();
-        return;
-    }
-
-    if (key == Qt::Key_Z) {
-        if (isDijkstraRunning || selectedVertices.size() < 2) return;
-
-        for (int i = 0; i < selectedVertices.size(); ++i) {
-            for (int j = i + 1; j < selectedVertices.size(); ++j) {
-                linkVertices(selectedVertices[i], selectedVertices[j], 1);
-            }
-        }
-
-        resetInputState();
-        update();
-        return;
-    }
-
-    if (key == Qt::Key_Delete) {
-        if (selectedVertices.size() <= 0 && selectedEdges.size() <= 0 || isDijkstraRunning) return;
-
-        for (int id : selectedEdges) {
-            deleteEdge(id);
-        }
-        selectedEdges.clear();
-
-        for (int id : selectedVertices) {
-            deleteVertex(id);
-        }
-        selectedVertices.clear();
-
-        resetInputState();
-        update();
-        return;
-    }
-
-    if (key == Qt::Key_Shift) {
-        isShiftPressed = true;
-        update();
-        return;
-    }
-}
-
-void Canvas::keyReleaseEvent(QKeyEvent *event) {
-    if (event->key() == Qt::Key_Shift) {
-        isShiftPressed = false;
-        update();
-    }
-}
+#include "utils.h"
+#include "canvas.h"
+#include "dijkstra.h"
+#include "kshortestpaths.h"
+#include "reachability.h"
+#include "trace.h"
+
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+
+#include <QMouseEvent>
+#include <QPainter>
+#include <QKeyEvent>
+#include <QFontMetrics>
+#include <QPainterPath>
+#include <QEventLoop>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <future>
+#include <new>
+#include <QFile>
+#include <QFileDialog>
+#include <QInputDialog>
+#include <QTextStream>
+
+Canvas::Canvas(QWidget *parent) : QMainWindow(parent) {
+    setFocusPolicy(Qt::StrongFocus);
+    setMouseTracking(true);
+    setFocus();
+    labels.setFont(font);
+
+    connect(layoutTimer, &QTimer::timeout, this, &Canvas::applyLayout);
+    connect(loadTimer, &QTimer::timeout, this, &Canvas::applyLoadedBatch);
+
+    statusTimer->setSingleShot(true);
+    connect(statusTimer, &QTimer::timeout, this, [this]() {
+        statusText.clear();
+        update();
+    });
+
+    connect(memoryTimer, &QTimer::timeout, this, [this]() {
+        if (itemMemory.version != model.getVersion()) measureItems();
+        memory = memoryReport();
+        update();
+    });
+}
+
+void delay(int milliseconds) {
+    QEventLoop loop;
+    QTimer::singleShot(milliseconds, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+
+template <typename Result>
+Result waitForResult(std::future<Result> &future, int pollMs) {
+    while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        delay(pollMs);
+    }
+    return future.get();
+}
+
+QPointF Canvas::getTransformedPos(const QPointF& pos) {
+    QTransform transform;
+    transform.translate(offset.x(), offset.y());
+    transform.scale(scaleFactor, scaleFactor);
+    return transform.inverted().map(pos);
+}
+
+int Canvas::getNumFromArray(std::vector<int> array) {
+    int num = 0;
+    int i = array.size();
+    for (int digit : array) {
+        num += digit * pow(10, i - 1);
+        --i;
+    }
+    return num;
+}
+
+QPointF Canvas::getAbsoluteCenter() {
+    QSize windowSize = this->size();
+    return {windowSize.rwidth() / 2.0f, windowSize.rheight() / 2.0f};
+}
+
+Vertex* Canvas::getClickedVertex(QPointF clickPos) {
+    Vertex* clickedVertex = nullptr;
+    for (const auto& [id, vertex] : vertices) {
+        bool isInRadius = QLineF(clickPos, vertex->pos).length() <= vertex->radius;
+        if (!isInRadius) continue;
+
+        clickedVertex = vertex;
+    }
+    return clickedVertex;
+}
+
+void Canvas::resetInputState() {
+    intPressed1.clear();
+    intPressed2.clear();
+    isFirstLink = true;
+    floatExponent1 = 0;
+    floatExponent2 = 0;
+}
+
+void Canvas::selectVertex(int id) {
+    vertices.at(id)->isSelected = true;
+    selectedVertices.push_back(id);
+}
+
+void Canvas::deselectFirstVertex() {
+    vertices.at(selectedVertices[0])->isSelected = false;
+    selectedVertices.erase(selectedVertices.begin());
+}
+
+void Canvas::deselectAllVertices() {
+    for (int id : selectedVertices) {
+        vertices.at(id)->isSelected = false;
+    }
+    selectedVertices.clear();
+}
+
+void Canvas::createVertex(QPointF pos, int radius) {
+    TRACE_SCOPE("Canvas::createVertex");
+    QString name = QString::number(totalVertices);
+    vertices.insert({totalVertices, new Vertex(name, totalVertices, radius, pos, this)});
+    model.addVertex(totalVertices, pos);
+    graphChanged();
+
+    if (selectedVertices.size() > 2) {
+        deselectAllVertices();
+    }
+    else if (selectedVertices.size() == 2) {
+        deselectFirstVertex();
+    }
+
+    selectVertex(totalVertices);
+    ++totalVertices;
+
+    update();
+}
+
+int Canvas::findEdge(int startId, int endId) const {
+    auto edge = edgeIndex.find(utils::edgeKey(startId, endId));
+    return edge == edgeIndex.end() ? -1 : edge->second;
+}
+
+void Canvas::attachEdge(Edge *edge) {
+    Vertex *start = vertices.at(edge->startId);
+    Vertex *end = vertices.at(edge->endId);
+
+    edge->outSlot = start->out.edgeId.size();
+    start->out.vertexId.push_back(edge->endId);
+    start->out.edgeId.push_back(edge->id);
+
+    edge->inSlot = end->in.edgeId.size();
+    end->in.vertexId.push_back(edge->startId);
+    end->in.edgeId.push_back(edge->id);
+
+    edges.insert({edge->id, edge});
+    edgeIndex.insert({utils::edgeKey(edge->startId, edge->endId), edge->id});
+    model.addEdge(edge->id, edge->startId, edge->endId, edge->weight);
+
+    // The reverse edge now shares the pair and moves aside
+    int reverseId = findEdge(edge->endId, edge->startId);
+    if (reverseId != -1) edges.at(reverseId)->invalidateGeometry();
+}
+
+void Canvas::detachEdge(Edge *edge) {
+    Vertex *start = vertices.at(edge->startId);
+    Vertex *end = vertices.at(edge->endId);
+
+    utils::swapAndPop(start->out.vertexId, start->out.edgeId, edge->outSlot);
+    if (edge->outSlot < start->out.edgeId.size()) {
+        edges.at(start->out.edgeId[edge->outSlot])->outSlot = edge->outSlot;
+    }
+
+    utils::swapAndPop(end->in.vertexId, end->in.edgeId, edge->inSlot);
+    if (edge->inSlot < end->in.edgeId.size()) {
+        edges.at(end->in.edgeId[edge->inSlot])->inSlot = edge->inSlot;
+    }
+
+    edgeIndex.erase(utils::edgeKey(edge->startId, edge->endId));
+    edges.erase(edge->id);
+    model.removeEdge(edge->id);
+
+    int reverseId = findEdge(edge->endId, edge->startId);
+    if (reverseId != -1) edges.at(reverseId)->invalidateGeometry();
+    delete edge;
+}
+
+void Canvas::moveVertex(Vertex *vertex, QPointF pos) {
+    vertex->pos = pos;
+    model.moveVertex(vertex->id, pos);
+
+    for (int edgeId : vertex->in.edgeId) {
+        edges.at(edgeId)->invalidateGeometry();
+    }
+    for (int edgeId : vertex->out.edgeId) {
+        edges.at(edgeId)->invalidateGeometry();
+    }
+}
+
+void Canvas::linkVertices(int firstId, int secondId, qreal weight) {
+    TRACE_SCOPE("Canvas::linkVertices");
+    if (hasEdge(firstId, secondId) || firstId == secondId) return;
+
+    attachEdge(new Edge(QString::number(weight), totalEdges, firstId, secondId, weight));
+    graphChanged();
+
+    ++totalEdges;
+
+    update();
+}
+
+void Canvas::applyTransaction(const GraphTransaction &transaction) {
+    TRACE_SCOPE("Canvas::applyTransaction");
+    // Deletions, including every edge incident to a deleted vertex
+    std::unordered_set<int> deletedEdges;
+    std::unordered_set<int> deletedVertices;
+    for (int id : transaction.vertexDeletes) {
+        auto vertex = vertices.find(id);
+        if (vertex == vertices.end()) continue;
+
+        deletedVertices.insert(id);
+        deletedEdges.insert(vertex->second->in.edgeId.begin(), vertex->second->in.edgeId.end());
+        deletedEdges.insert(vertex->second->out.edgeId.begin(), vertex->second->out.edgeId.end());
+    }
+    for (int id : transaction.edgeDeletes) {
+        if (edges.find(id) != edges.end()) deletedEdges.insert(id);
+    }
+
+    for (int id : deletedEdges) {
+        detachEdge(edges.at(id));
+    }
+    for (int id : deletedVertices) {
+        delete vertices.at(id);
+        vertices.erase(id);
+        model.removeVertex(id);
+    }
+
+    selectedEdges.erase(std::remove_if(selectedEdges.begin(), selectedEdges.end(),
+                                       [&](int id) { return deletedEdges.count(id) > 0; }), selectedEdges.end());
+    selectedVertices.erase(std::remove_if(selectedVertices.begin(), selectedVertices.end(),
+                                          [&](int id) { return deletedVertices.count(id) > 0; }), selectedVertices.end());
+
+    // Insertions
+    for (QPointF pos : transaction.vertexInserts) {
+        vertices.insert({totalVertices, new Vertex(QString::number(totalVertices), totalVertices, VERTEX_RADIUS, pos, this)});
+        model.addVertex(totalVertices, pos);
+        ++totalVertices;
+    }
+
+    std::unordered_set<uint64_t> pendingEdges;
+    std::unordered_map<int, int> outDegrees;
+    std::unordered_map<int, int> inDegrees;
+    std::vector<const GraphTransaction::PendingEdge*> accepted;
+    accepted.reserve(transaction.edgeInserts.size());
+    pendingEdges.reserve(transaction.edgeInserts.size());
+
+    for (const auto& pending : transaction.edgeInserts) {
+        if (pending.startId == pending.endId) continue;
+        if (vertices.find(pending.startId) == vertices.end() || vertices.find(pending.endId) == vertices.end()) continue;
+
+        uint64_t key = utils::edgeKey(pending.startId, pending.endId);
+        if (edgeIndex.count(key) || !pendingEdges.insert(key).second) continue;
+
+        accepted.push_back(&pending);
+        ++outDegrees[pending.startId];
+        ++inDegrees[pending.endId];
+    }
+
+    for (const auto& [id, degree] : outDegrees) {
+        Vertex *vertex = vertices.at(id);
+        vertex->out.vertexId.reserve(vertex->out.vertexId.size() + degree);
+        vertex->out.edgeId.reserve(vertex->out.edgeId.size() + degree);
+    }
+    for (const auto& [id, degree] : inDegrees) {
+        Vertex *vertex = vertices.at(id);
+        vertex->in.vertexId.reserve(vertex->in.vertexId.size() + degree);
+        vertex->in.edgeId.reserve(vertex->in.edgeId.size() + degree);
+    }
+    edges.reserve(edges.size() + accepted.size());
+    edgeIndex.reserve(edgeIndex.size() + accepted.size());
+
+    for (const GraphTransaction::PendingEdge *pending : accepted) {
+        attachEdge(new Edge(QString::number(pending->weight), totalEdges, pending->startId, pending->endId, pending->weight));
+        ++totalEdges;
+    }
+
+    graphChanged();
+    update();
+}
+
+void Canvas::updateScene(const QRectF& sceneRect) {
+    if (sceneRect.isNull()) return;
+
+    // The profiler and the tiles cover the whole window every frame
+    if (profiler.isEnabled() || isTiledRendering) {
+        update();
+        return;
+    }
+
+    QRectF screenRect(offset + sceneRect.topLeft() * scaleFactor, sceneRect.size() * scaleFactor);
+    update(screenRect.toAlignedRect().adjusted(-1, -1, 1, 1));
+}
+
+QRectF Canvas::vertexBounds(int id, bool withEdges) {
+    auto vertex = vertices.find(id);
+    if (vertex == vertices.end()) return QRectF();
+
+    QRectF rect = vertex->second->bounds(this);
+    if (withEdges) {
+        for (int edgeId : vertex->second->in.edgeId) {
+            rect = rect.united(edges.at(edgeId)->bounds(this));
+        }
+        for (int edgeId : vertex->second->out.edgeId) {
+            rect = rect.united(edges.at(edgeId)->bounds(this));
+        }
+    }
+
+    return rect;
+}
+
+QRectF Canvas::edgeBounds(int id) {
+    auto edge = edges.find(id);
+    return edge == edges.end() ? QRectF() : edge->second->bounds(this);
+}
+
+QRectF Canvas::linkPreviewBounds() {
+    if (selectedVertices.size() != 2) return QRectF();
+
+    int firstId = selectedVertices[0];
+    int secondId = selectedVertices[1];
+
+    // Typed weights are never wider than this, whatever is entered next
+    fakeEdge->displayText = "0000000.";
+    fakeEdge->startId = firstId;
+    fakeEdge->endId = secondId;
+    QRectF rect = fakeEdge->bounds(this);
+
+    fakeEdge->startId = secondId;
+    fakeEdge->endId = firstId;
+    rect = rect.united(fakeEdge->bounds(this));
+
+    // Existing edges of the pair move aside while a weight is typed
+    rect = rect.united(edgeBounds(findEdge(firstId, secondId)));
+    rect = rect.united(edgeBounds(findEdge(secondId, firstId)));
+
+    return rect;
+}
+
+void Canvas::graphChanged() {
+    allPairs.clear();
+    stopLayout();
+    if (server.isRunning()) server.setGraph(model.snapshot());
+}
+
+void Canvas::toggleLayout() {
+    if (forceLayout.isRunning()) {
+        stopLayout();
+        return;
+    }
+
+    if (vertices.empty()) return;
+
+    forceLayout.start(*model.snapshot());
+    layoutTimer->start(LAYOUT_FRAME_MS);
+}
+
+void Canvas::stopLayout() {
+    if (!forceLayout.isRunning()) return;
+
+    forceLayout.stop();
+    layoutTimer->stop();
+    applyLayout();
+}
+
+void Canvas::applyLayout() {
+    std::vector<int> ids;
+    std::vector<QPointF> positions;
+
+    if (forceLayout.takePositions(ids, positions)) {
+        for (size_t i = 0; i < ids.size(); ++i) {
+            auto vertex = vertices.find(ids[i]);
+            if (vertex == vertices.end()) continue;
+
+            moveVertex(vertex->second, positions[i]);
+        }
+        update();
+    }
+
+    if (!forceLayout.isRunning()) layoutTimer->stop();
+}
+
+void Canvas::openGraph(const QString &path) {
+    if (isLoading) return;
+
+    beginLoading();
+    loader.start(path);
+}
+
+void Canvas::generateGraph(const QString &spec) {
+    if (isLoading) return;
+
+    GraphGenerator::Options options;
+    QString error;
+    if (!GraphGenerator::parse(spec, options, error)) {
+        showStatus("Could not generate the graph: " + error);
+        return;
+    }
+
+    beginLoading();
+    loader.startGenerated([options]() {
+        return GraphGenerator::generate(options);
+    });
+}
+
+void Canvas::startServer(const QString &path) {
+    std::string error;
+    if (!server.start(path.toStdString(), error)) {
+        showStatus("Could not serve queries: " + QString::fromStdString(error));
+        return;
+    }
+
+    server.setGraph(model.snapshot());
+    showStatus(QString("Serving queries on %1").arg(path));
+}
+
+// Replaces the graph with the batches the loader is about to publish
+void Canvas::beginLoading() {
+    cancelDijkstra();
+    resetInputState();
+
+    GraphTransaction transaction(this);
+    for (const auto& [id, vertex] : vertices) {
+        transaction.removeVertex(id);
+    }
+    transaction.commit();
+
+    loadedIds.clear();
+    statusText.clear();
+    isLoading = true;
+    loadTimer->start(LOAD_FRAME_MS);
+}
+
+void Canvas::showStatus(const QString &text) {
+    statusText = text;
+    statusTimer->start(STATUS_MS);
+    update();
+}
+
+void Canvas::applyLoadedBatch() {
+    bool isFinished = !loader.isRunning();
+    GraphLoader::Batch batch;
+
+    if (loader.takeBatch(batch)) {
+        bool isFirstBatch = loadedIds.empty();
+
+        GraphTransaction transaction(this);
+        for (QPointF pos : batch.vertices) {
+            loadedIds.push_back(transaction.addVertex(pos));
+        }
+        for (const GraphLoader::Link& link : batch.edges) {
+            transaction.addEdge(loadedIds[link.from], loadedIds[link.to], link.weight);
+        }
+        transaction.commit();
+
+        // Center the view on the first vertices so there is something to look at
+        if (isFirstBatch && !batch.vertices.empty()) {
+            QPointF center = {0, 0};
+            for (QPointF pos : batch.vertices) {
+                center += pos / batch.vertices.size();
+            }
+            offset = QPointF(width() / 2.0, height() / 2.0) - center * scaleFactor;
+        }
+    }
+
+    if (!isFinished) return;
+
+    loadTimer->stop();
+    isLoading = false;
+    loadedIds.clear();
+
+    QString error = loader.getError();
+    if (!error.isEmpty()) showStatus("Could not load the graph: " + error);
+
+    update();
+}
+
+void Canvas::saveGraph() {
+    QString path = QFileDialog::getSaveFileName(this, "Save graph", "graph.txt", "Graph (*.txt)");
+    if (path.isEmpty()) return;
+
+    GraphLoader::save(*model.snapshot(), path);
+}
+
+void Canvas::drawVertices(QPainter& painter) {
+    for (const auto& [id, vertex] : vertices) {
+        vertex->draw(this, vertexBatch);
+    }
+
+    submitLayer(painter, vertexBatch);
+}
+
+void Canvas::drawEdges(QPainter& painter) {
+    for (const auto& [id, edge] : edges) {
+        bool betweenSelected = vertices.at(edge->startId)->isSelected && vertices.at(edge->endId)->isSelected;
+        bool isBoth = betweenSelected && intPressed1.size() > 0;
+        edge->draw(this, edgeBatch, isBoth);
+    }
+
+    submitLayer(painter, edgeBatch);
+}
+
+void Canvas::drawFakeEdges(QPainter& painter) {
+    if (intPressed1.size() <= 0) return;
+
+    fakeEdge->startId = selectedVertices[isShiftPressed];
+    fakeEdge->endId = selectedVertices[!isShiftPressed];
+    if (!hasEdge(fakeEdge->startId, fakeEdge->endId)) {
+        qreal weight = getNumFromArray(intPressed1) / (floatExponent1 ? floatExponent1 : 1.f);
+        fakeEdge->displayText = QString::number(weight) + (floatExponent1 == 1 && isFirstLink ? "." : "");
+        fakeEdge->draw(this, fakeEdgeBatch, !isFirstLink, FAKE_EDGE_OPACITY);
+    }
+
+    if (isFirstLink) {
+        submitLayer(painter, fakeEdgeBatch);
+        return;
+    }
+
+    fakeEdge->startId = selectedVertices[!isShiftPressed];
+    fakeEdge->endId = selectedVertices[isShiftPressed];
+
+    if (hasEdge(fakeEdge->startId, fakeEdge->endId)) {
+        submitLayer(painter, fakeEdgeBatch);
+        return;
+    }
+
+    if (intPressed2.size() <= 0) {
+        fakeEdge->weight = -1;
+        fakeEdge->displayText = "";
+    }
+    else {
+        qreal weight = getNumFromArray(intPressed2)  / (floatExponent2 ? floatExponent2 : 1.f);
+        fakeEdge->displayText = QString::number(weight) + (floatExponent2 == 1 ? "." : "");
+    }
+
+    fakeEdge->draw(this, fakeEdgeBatch, true, FAKE_EDGE_OPACITY);
+    submitLayer(painter, fakeEdgeBatch);
+}
+
+void Canvas::drawGrid(QPainter& painter, const QPointF& center) {
+    const qreal xCenterOffset = center.x() / scaleFactor;
+    const qreal yCenterOffset = center.y() / scaleFactor;
+
+    const qreal leftBorder   = screenCenter.x() - xCenterOffset;
+    const qreal rightBorder  = screenCenter.x() + xCenterOffset;
+    const qreal topBorder    = screenCenter.y() - yCenterOffset;
+    const qreal bottomBorder = screenCenter.y() + yCenterOffset;
+
+    const qreal gap = scaleFactor > 0.8 ? GRID_GAP : GRID_GAP * GRID_DIVISON;
+    const int actualDivision = scaleFactor > 0.8 ? GRID_DIVISON : 1;
+
+    const int left   = utils::absCeil((leftBorder - LINE_THICKNESS) / gap);
+    const int right  = utils::absCeil((rightBorder + LINE_THICKNESS) / gap);
+    const int top    = utils::absCeil((topBorder - LINE_THICKNESS) / gap);
+    const int bottom = utils::absCeil((bottomBorder + LINE_THICKNESS) / gap);
+
+    QColor gridColor = QColor(gridLightnes, gridLightnes, gridLightnes, 255);
+    QColor axisColor = QColor(gridLightnes - 50, gridLightnes - 50, gridLightnes - 50, 255);
+
+    auto lineStyle = [&](int i) -> DrawBatch::Style {
+        if (i == 0) return {axisColor, Qt::transparent, 1};
+        else if (i % actualDivision * actualDivision == 0) return {gridColor, Qt::transparent, 0.5f};
+        else if (i % actualDivision == 0) return {gridColor, Qt::transparent, 0.3f};
+        return {gridColor, Qt::transparent, 0.1f};
+    };
+
+    for (int i = left; i <= right; ++i) {
+        gridBatch.addLine(lineStyle(i), QLineF({gap * i, bottomBorder},
+                                               {gap * i, topBorder}));
+    }
+
+    for (int i = top; i <= bottom; ++i) {
+        gridBatch.addLine(lineStyle(i), QLineF({rightBorder , gap * i},
+                                               {leftBorder , gap * i}));
+    }
+
+    submitLayer(painter, gridBatch);
+}
+
+void Canvas::submitLayer(QPainter& painter, DrawBatch& batch) {
+    // The tiled renderer draws every layer at the end of the frame
+    if (!isTiledRendering) batch.flush(painter, labels);
+}
+
+void Canvas::drawOverlays(QPainter& painter) {
+    painter.setFont(textFont);
+    drawTutorial(painter);
+    drawAllPairs(painter);
+    drawStatus(painter);
+    profiler.draw(painter, width() - PROFILER_WIDTH, 5);
+    if (memoryTimer->isActive()) memory.draw(painter, width() - MEMORY_WIDTH, height() - memory.panelHeight() - 10);
+}
+
+void Canvas::measureItems() {
+    itemMemory = ItemMemory();
+    itemMemory.version = model.getVersion();
+    for (const auto& [id, vertex] : vertices) {
+        itemMemory.vertexStrings += MemoryReport::stringBytes(vertex->displayName) + MemoryReport::stringBytes(vertex->weightText);
+        itemMemory.adjacency += MemoryReport::vectorBytes(vertex->in.vertexId) + MemoryReport::vectorBytes(vertex->in.edgeId)
+                                + MemoryReport::vectorBytes(vertex->out.vertexId) + MemoryReport::vectorBytes(vertex->out.edgeId);
+        itemMemory.adjacencyEntries += vertex->in.edgeId.size() + vertex->out.edgeId.size();
+    }
+    for (const auto& [id, edge] : edges) {
+        itemMemory.edgeStrings += MemoryReport::stringBytes(edge->displayText);
+    }
+    itemMemory.model = model.memoryUsage();
+}
+
+MemoryReport Canvas::memoryReport() const {
+    MemoryReport report;
+
+    report.add("Vertex map", vertices.size(), MemoryReport::hashBytes(vertices));
+    report.add("Vertex objects", vertices.size(), vertices.size() * MemoryReport::heapBytes(sizeof(Vertex)));
+    report.add("Vertex strings", vertices.size(), itemMemory.vertexStrings);
+    report.add("Adjacency", itemMemory.adjacencyEntries, itemMemory.adjacency);
+    report.add("Edge map", edges.size(), MemoryReport::hashBytes(edges));
+    report.add("Edge objects", edges.size(), edges.size() * MemoryReport::heapBytes(sizeof(Edge)));
+    report.add("Edge strings", edges.size(), itemMemory.edgeStrings);
+    report.add("Edge index", edgeIndex.size(), MemoryReport::hashBytes(edgeIndex));
+    report.add("Graph model", vertices.size() + edges.size(), itemMemory.model);
+
+    report.add("Dijkstra events", activeEvents ? activeEvents->size() : 0,
+               activeEvents ? MemoryReport::vectorBytes(*activeEvents) : 0);
+    report.add("Visualization", djCheckedVertices.size() + djCheckedEdges.size() + djEndAnimation.size(),
+               MemoryReport::hashBytes(djCheckedVertices) + MemoryReport::hashBytes(djCheckedEdges)
+               + MemoryReport::hashBytes(djEndAnimation));
+    report.add("Selection", selectedVertices.size() + selectedEdges.size(),
+               MemoryReport::vectorBytes(selectedVertices) + MemoryReport::vectorBytes(selectedEdges));
+    report.add("All-pairs distances", allPairs.getIds().size(), allPairs.memoryUsage());
+    report.add("Landmarks", landmarks ? landmarks->getLandmarkIds().size() : 0, landmarks ? landmarks->memoryUsage() : 0);
+
+    report.add("Label cache", labels.size(), labels.memoryUsage());
+    report.add("Draw batches", 4, gridBatch.memoryUsage() + edgeBatch.memoryUsage()
+                                  + fakeEdgeBatch.memoryUsage() + vertexBatch.memoryUsage());
+    report.add("Render tiles", tiledRenderer.tileCount(), tiledRenderer.memoryUsage());
+
+    return report;
+}
+
+// Routes come shortest first, so a vertex keeps its distance on the shortest route through it
+void Canvas::highlightRoutes(int fromId, int toId, const std::vector<Route> &routes) {
+    djStartVertex = fromId;
+    djEndVertex = toId;
+
+    for (const Route& route : routes) {
+        for (int edgeId : route.edgeIds) {
+            djCheckedEdges.insert(edgeId);
+        }
+        for (size_t i = 0; i < route.vertexIds.size(); ++i) {
+            Vertex *vertex = vertices.at(route.vertexIds[i]);
+            if (!vertex->hasWeight(this)) vertex->setWeight(route.distances[i], weightEpoch);
+            if (i > 0 && i + 1 < route.vertexIds.size()) djCheckedVertices.insert(vertex->id);
+        }
+    }
+}
+
+// Takes finished landmarks, and starts building them for snapshot unless
+// they are current or a build is still running
+void Canvas::updateLandmarks(const std::shared_ptr<const GraphSnapshot> &snapshot) {
+    if (landmarkBuild.valid() && landmarkBuild.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        landmarks = landmarkBuild.get();
+    }
+    if (landmarkBuild.valid()) return;
+    if (landmarks && landmarks->getVersion() == snapshot->getVersion()) return;
+
+    std::vector<int> previous = landmarks ? landmarks->getLandmarkIds() : std::vector<int>();
+    landmarkBuild = std::async(std::launch::async, [snapshot, previous]() {
+        auto next = std::make_shared<Landmarks>();
+        next->build(*snapshot, previous, Landmarks::COUNT, VertexOrder::compute(*snapshot, Landmarks::ORDER));
+        return std::shared_ptr<const Landmarks>(next);
+    });
+}
+
+void Canvas::toggleMemoryReport() {
+    if (memoryTimer->isActive()) {
+        memoryTimer->stop();
+    }
+    else {
+        measureItems();
+        memory = memoryReport();
+        memoryTimer->start(MEMORY_REFRESH_MS);
+    }
+
+    update();
+}
+
+void Canvas::saveMemoryReport() {
+    QString path = QFileDialog::getSaveFileName(this, "Save memory report", "memory.csv", "CSV (*.csv)");
+    if (path.isEmpty()) return;
+
+    measureItems();
+    if (!memoryReport().save(path)) showStatus("Could not write " + path);
+}
+
+void Canvas::drawStatus(QPainter& painter) {
+    QString text = statusText;
+    if (isLoading) text = QString("Loading: %1 vertices, %2 edges").arg(vertices.size()).arg(edges.size());
+    if (text.isEmpty()) return;
+
+    const int lineHeight = 18;
+    const int textPaddingX = 6;
+    const int rectOffsetY = 14;
+    const int textOffsetX = 13;
+    int y = height() - 10;
+
+    int textWidth = painter.fontMetrics().horizontalAdvance(text);
+    painter.fillRect(QRect(10, y - rectOffsetY, textWidth + textPaddingX, lineHeight), Qt::white);
+    painter.drawText(textOffsetX, y, text);
+}
+
+void Canvas::drawTutorial(QPainter& painter) {
+    const int startY = 5;
+    const int lineHeight = 18;
+    const int textPaddingX = 6;
+    const int textPaddingY = 18;
+    const int rectOffsetY = 14;
+    const int textOffsetX = 13;
+
+    int y = startY;
+
+    for (const QString& line : tutorialText) {
+        y += lineHeight;
+
+        int textWidth = painter.fontMetrics().horizontalAdvance(line);
+        QRect textRect(10, y - rectOffsetY, textWidth + textPaddingX, lineHeight);
+        painter.fillRect(textRect, Qt::white);
+
+        painter.drawText(textOffsetX, y, line);
+    }
+}
+
+void Canvas::drawAllPairs(QPainter& painter) {
+    if (allPairs.isEmpty() || selectedVertices.size() != 2) return;
+
+    int firstId = selectedVertices[0];
+    int secondId = selectedVertices[1];
+    if (!allPairs.contains(firstId) || !allPairs.contains(secondId)) return;
+
+    auto distanceText = [&](int fromId, int toId) {
+        qreal distance = allPairs.distance(fromId, toId);
+        QString value = distance == INF ? "∞" : QString::number(distance);
+        return vertices.at(fromId)->displayName + " → " + vertices.at(toId)->displayName + ": " + value;
+    };
+
+    const int lineHeight = 18;
+    const int textPaddingX = 6;
+    const int rectOffsetY = 14;
+    const int textOffsetX = 13;
+
+    QStringList lines = {distanceText(firstId, secondId), distanceText(secondId, firstId)};
+
+    painter.save();
+    painter.resetTransform();
+
+    int y = height() - lineHeight * lines.size();
+    for (const QString& line : lines) {
+        int textWidth = painter.fontMetrics().horizontalAdvance(line);
+        QRect textRect(10, y - rectOffsetY, textWidth + textPaddingX, lineHeight);
+        painter.fillRect(textRect, Qt::white);
+
+        painter.drawText(textOffsetX, y, line);
+        y += lineHeight;
+    }
+
+    painter.restore();
+}
+
+void Canvas::paintEvent(QPaintEvent *event) {
+    TRACE_SCOPE("Canvas::paintEvent");
+    profiler.beginFrame();
+    labels.beginFrame();
+
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.translate(offset);
+    painter.scale(scaleFactor, scaleFactor);
+
+    QPointF center = getAbsoluteCenter();
+    screenCenter = (center - offset) / scaleFactor;
+    halfScreenDiagonal = qSqrt(QPointF::dotProduct(center, center)) / scaleFactor;
+
+    // Items outside a partial repaint are skipped, the painter is clipped to it anyway
+    QRect dirtyRect = event->rect();
+    isPartialPaint = dirtyRect != rect();
+    paintBounds = QRectF((QPointF(dirtyRect.topLeft()) - offset) / scaleFactor, QSizeF(dirtyRect.size()) / scaleFactor);
+
+    labels.setFont(font);
+
+    profiler.beginSection();
+    drawGrid(painter, center);
+    profiler.endSection(FrameProfiler::GRID);
+
+    painter.setFont(font);
+
+    profiler.beginSection();
+    drawEdges(painter);
+    profiler.endSection(FrameProfiler::EDGES);
+
+    profiler.beginSection();
+    drawFakeEdges(painter);
+    profiler.endSection(FrameProfiler::FAKE_EDGES);
+
+    profiler.beginSection();
+    drawVertices(painter);
+    profiler.endSection(FrameProfiler::VERTICES);
+
+    if (isTiledRendering) {
+        profiler.beginSection();
+        tiledRenderer.render(painter, {&gridBatch, &edgeBatch, &fakeEdgeBatch, &vertexBatch}, labels,
+                             size(), devicePixelRatioF(), offset, scaleFactor);
+        profiler.endSection(FrameProfiler::TILES);
+
+        gridBatch.clear();
+        edgeBatch.clear();
+        fakeEdgeBatch.clear();
+        vertexBatch.clear();
+    }
+
+    // Panels stay above the graph in both paths
+    drawOverlays(painter);
+
+    profiler.endFrame();
+}
+
+void Canvas::cancelDijkstra() {
+    ++weightEpoch;
+    ++iteretion;
+    djCheckedVertices.clear();
+    djCheckedEdges.clear();
+    djEndAnimation.clear();
+    djStartVertex = -1;
+    djEndVertex = -1;
+    djCurrentVertex = -1;
+
+    update();
+}
+
+void Canvas::visualizeDijkstra(const std::unordered_set<int> &graphVertices, const Events &events, int startIteretion) {
+    TRACE_SCOPE("Canvas::visualizeDijkstra");
+    // A new run started from a nested event loop replaces the log until it returns
+    const Events *previousEvents = activeEvents;
+    activeEvents = &events;
+
+    for (Event event : events) {
+        if (startIteretion != iteretion) break;
+
+        // Only the vertex or edge an event touches is repainted
+        QRectF dirty;
+
+        if (event.name == SET_START_VERTEX) {
+            djStartVertex = event.vertexId;
+            dirty = vertexBounds(event.vertexId);
+            delay(START_DELAY_MS);
+        }
+        else if (event.name == SET_CURRENT_VERTEX) {
+            dirty = vertexBounds(djCurrentVertex).united(vertexBounds(event.vertexId));
+            djCurrentVertex = event.vertexId;
+            delay(STEP_DELAY_MS);
+            updateScene(dirty);
+            delay(STEP_DELAY_MS);
+        }
+        else if (event.name == SET_END_VERTEX) {
+            djEndVertex = event.vertexId;
+            dirty = vertexBounds(event.vertexId);
+        }
+        else if (event.name == CHECK_VERTEX) {
+            djCheckedVertices.insert(event.vertexId);
+            dirty = vertexBounds(event.vertexId);
+            delay(STEP_DELAY_MS);
+        }
+        else if (event.name == CHECK_EDGE) {
+            djCheckedEdges.insert(event.edgeId);
+            dirty = edgeBounds(event.edgeId);
+        }
+        else if (event.name == UNCHECK_VERTEX) {
+            djCheckedVertices.erase(event.vertexId);
+            dirty = vertexBounds(event.vertexId);
+        }
+        else if (event.name == UNCHECK_EDGE) {
+            djCheckedEdges.erase(event.edgeId);
+            dirty = edgeBounds(event.edgeId);
+            delay(EDGE_STEP_DELAY_MS);
+        }
+        else if (event.name == SET_WEIGHT) {
+            auto vertex = vertices.find(event.vertexId);
+            if (vertex != vertices.end()) {
+                dirty = vertex->second->bounds(this);
+                vertex->second->setWeight(event.weight, weightEpoch);
+                dirty = dirty.united(vertex->second->bounds(this));
+            }
+        }
+
+        updateScene(dirty);
+    }
+
+    // Larger runs are shown at once, a per-vertex finale would take minutes
+    if (graphVertices.size() > Dijkstra::ANIMATION_LIMIT) {
+        activeEvents = previousEvents;
+        return;
+    }
+
+    auto animationBounds = [&]() {
+        QRectF rect;
+        for (int id : graphVertices) {
+            rect = rect.united(vertexBounds(id));
+        }
+        return rect;
+    };
+
+    for (int id : graphVertices) {
+        if (startIteretion != iteretion) break;
+
+        delay(END_DELAY_MS);
+        djEndAnimation.insert(id);
+        updateScene(vertexBounds(id));
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        if (startIteretion != iteretion) break;
+
+        delay(FLICK_DELAY_MS);
+        djEndAnimation = graphVertices;
+        updateScene(animationBounds());
+
+        delay(FLICK_DELAY_MS);
+        djEndAnimation.clear();
+        updateScene(animationBounds());
+    }
+
+    activeEvents = previousEvents;
+}
+
+void Canvas::exportAllPairs() {
+    QString path = QFileDialog::getSaveFileName(this, "Export all-pairs distances", "distances.csv", "CSV (*.csv)");
+    if (path.isEmpty()) return;
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) return;
+
+    QTextStream out(&file);
+    const std::vector<int>& ids = allPairs.getIds();
+
+    for (int id : ids) {
+        out << "," << vertices.at(id)->displayName;
+    }
+    out << "\n";
+
+    for (int fromId : ids) {
+        out << vertices.at(fromId)->displayName;
+        for (int toId : ids) {
+            qreal distance = allPairs.distance(fromId, toId);
+            out << ",";
+            // Shortest text that reads back as the same double
+            if (distance != INF) out << QString::number(distance, 'g', QLocale::FloatingPointShortest);
+        }
+        out << "\n";
+    }
+}
+
+void Canvas::toggleTrace() {
+    if (!Trace::isEnabled()) {
+        Trace::start();
+        return;
+    }
+
+    Trace::stop();
+
+    QString path = QFileDialog::getSaveFileName(this, "Save trace", "trace.json", "Chrome trace (*.json)");
+    if (path.isEmpty()) return;
+
+    Trace::dump(path.toStdString());
+}
+
+void Canvas::wheelEvent(QWheelEvent *event) {
+    QPointF cursorPos = event->position();
+    QPointF scenePos = (cursorPos - offset) / scaleFactor;
+
+    qreal factor = (event->angleDelta().y() > 0) ? 1.2 : 0.8;
+    if (scaleFactor > ZOOM_OUT_LIMIT || factor > 1) {
+        scaleFactor *= factor;
+    }
+
+    offset = cursorPos - scenePos * scaleFactor;
+
+    update();
+}
+
+void Canvas::mousePressEvent(QMouseEvent *event) {
+    if (event->button() == Qt::LeftButton) {
+        resetInputState();
+
+        currentTool->onLeftClick(event);
+    }
+
+    if (event->button() == Qt::MiddleButton) {
+        lastMousePos = event->pos();
+        this->setCursor(PAN_CURSOR);
+    }
+}
+
+void Canvas::mouseMoveEvent(QMouseEvent *event) {
+    if (draggingVertex && (event->buttons() & Qt::LeftButton)) {
+        stopLayout();
+
+        QPointF transformedPos = getTransformedPos(event->pos());
+        QPointF mainVertPos = draggingVertex->pos;
+
+        // Old and new area of the moved vertices and their edges
+        QRectF dirty;
+        for (int id : selectedVertices) {
+            dirty = dirty.united(vertexBounds(id, true));
+        }
+
+        for (int id : selectedVertices) {
+            Vertex *vertex = vertices.at(id);
+            QPointF vertOffset = mainVertPos - vertex->pos;
+            moveVertex(vertex, transformedPos + draggingOffset - vertOffset);
+        }
+
+        for (int id : selectedVertices) {
+            dirty = dirty.united(vertexBounds(id, true));
+        }
+
+        updateScene(dirty);
+    }
+
+    if (event->buttons() & Qt::MiddleButton) {
+        QPoint delta = event->pos() - lastMousePos;
+        lastMousePos = event->pos();
+        offset += delta;
+        update();
+    }
+}
+
+void Canvas::mouseReleaseEvent(QMouseEvent *event) {
+    draggingVertex = nullptr;
+    draggingOffset = {0, 0};
+    this->setCursor(currentTool->getCursor());
+}
+
+void Canvas::keyPressEvent(QKeyEvent *event) {
+    int key = event->key();
+
+    if (key == Qt::Key_Return || key == Qt::Key_E) {
+        if (!intPressed1.size()) return;
+        if (selectedVertices.size() != 2) return;
+
+        linkVertices(selectedVertices[isShiftPressed], selectedVertices[!isShiftPressed], getNumFromArray(intPressed1) / (floatExponent1 ? floatExponent1 : 1.f));
+        if (intPressed2.size()) linkVertices(selectedVertices[!isShiftPressed], selectedVertices[isShiftPressed], getNumFromArray(intPressed2) / (floatExponent2 ? floatExponent2 : 1.f));
+
+        selectedEdges.clear();
+        deselectFirstVertex();
+
+        resetInputState();
+        update();
+        return;
+    }
+
+    if (key >= '0' && key <= '9') {
+        if (selectedVertices.size() != 2) return;
+        if (hasEdge(selectedVertices[0], selectedVertices[1])) return;
+
+        if (isFirstLink) {
+            if (intPressed1.size() == 0 && key == 0 ) return;
+            if (intPressed1.size() == 6) return;
+
+            intPressed1.push_back(key - '0');
+            if (floatExponent1) floatExponent1 *= 10;
+        }
+        else {
+            if (hasEdge(selectedVertices[1], selectedVertices[0])) return;
+            if (intPressed2.size() == 0 && key == 0 ) return;
+            if (intPressed2.size() == 6) return;
+
+            intPressed2.push_back(key - '0');
+            if (floatExponent2) floatExponent2 *= 10;
+        }
+
+        updateScene(linkPreviewBounds());
+        return;
+    }
+
+    if (key == '.' || key == ',') {
+        if (!intPressed1.size()) return;
+        if (isFirstLink) {
+            if (!floatExponent1) floatExponent1 = 1;
+        }
+        else {
+            if (!floatExponent2) floatExponent2 = 1;
+        }
+
+        updateScene(linkPreviewBounds());
+        return;
+    }
+
+    if (key == Qt::Key_Space) {
+        if (!intPressed1.size()) return;
+        isFirstLink = false;
+
+        updateScene(linkPreviewBounds());
+        return;
+    }
+
+    if (key == Qt::Key_Backspace) {
+        if (!intPressed1.size()) return;
+
+        if (isFirstLink) {
+            intPressed1.pop_back();
+            if (floatExponent1) floatExponent1 /= 10;
+        }
+        else {
+            if (!intPressed2.size()) {
+                floatExponent2 = 0;
+                isFirstLink = true;
+                updateScene(linkPreviewBounds());
+                return;
+            }
+            intPressed2.pop_back();
+            if (!intPressed2.size()) {
+                floatExponent2 = 0;
+            }
+            else if (floatExponent2) {
+                floatExponent2 /= 10;
+            }
+        }
+
+        updateScene(linkPreviewBounds());
+        return;
+    }
+
+    if (key == Qt::Key_V) {
+        currentTool = selectTool;
+        this->setCursor(currentTool->getCursor());
+        return;
+    }
+
+    if (key == Qt::Key_B) {
+        currentTool = penTool;
+        this->setCursor(currentTool->getCursor());
+        return;
+    }
+
+    // Algorithms, files and layout wait until the whole graph is loaded
+    bool isBlockedByLoading = key == Qt::Key_F || key == Qt::Key_R || key == Qt::Key_K || key == Qt::Key_Q || key == Qt::Key_G || key == Qt::Key_X
+                           || key == Qt::Key_L || key == Qt::Key_O || key == Qt::Key_S || key == Qt::Key_N;
+    if (isLoading && isBlockedByLoading) return;
+
+    if (key == Qt::Key_F) {
+        cancelDijkstra();
+
+        if (selectedVertices.size() != 1) return;
+
+        int startId = selectedVertices[0];
+        selectedEdges.clear();
+        deselectAllVertices();
+        int startIteretion = iteretion;
+
+        // The run works on a pinned snapshot, so editing can continue meanwhile
+        std::shared_ptr<const GraphSnapshot> snapshot = model.snapshot();
+        std::future<Events> result = std::async(std::launch::async, [snapshot, startId]() {
+            return Dijkstra::run(*snapshot, startId);
+        });
+
+        Events events;
+        {
+            TRACE_SCOPE("Canvas::waitForDijkstra");
+            events = waitForResult(result, RESULT_POLL_MS);
+        }
+
+        // Every reachable vertex gets a weight event
+        std::unordered_set<int> subGraphVertices;
+        for (const Event& event : events) {
+            if (event.name == SET_WEIGHT) subGraphVertices.insert(event.vertexId);
+        }
+
+        visualizeDijkstra(subGraphVertices, events, startIteretion);
+
+        resetInputState();
+        return;
+    }
+
+    if (key == Qt::Key_R) {
+        if (selectedVertices.empty()) return;
+
+        std::shared_ptr<const GraphSnapshot> snapshot = model.snapshot();
+        std::vector<int> sourceIds = selectedVertices;
+        std::future<std::vector<int>> result = std::async(std::launch::async, [snapshot, sourceIds]() {
+            Reachability reachability(*snapshot);
+            std::vector<int> reached;
+            for (int sourceId : sourceIds) {
+                std::vector<int> ids = reachability.from(sourceId);
+                reached.insert(reached.end(), ids.begin(), ids.end());
+            }
+            return reached;
+        });
+
+        std::vector<int> reached = waitForResult(result, RESULT_POLL_MS);
+        if (snapshot->getVersion() != model.getVersion()) return;
+
+        for (int id : reached) {
+            if (!vertices.at(id)->isSelected) selectVertex(id);
+        }
+
+        resetInputState();
+        update();
+        return;
+    }
+
+    if (key == Qt::Key_K) {
+        if (selectedVertices.size() != 2) return;
+
+        // Same direction as entering a weight: first selected to second, Shift reverses
+        int fromId = selectedVertices[isShiftPressed];
+        int toId = selectedVertices[!isShiftPressed];
+        cancelDijkstra();
+        selectedEdges.clear();
+        deselectAllVertices();
+        resetInputState();
+
+        // Graphs built for the landmarks of this version are reused
+        std::shared_ptr<const GraphSnapshot> snapshot = model.snapshot();
+        std::shared_ptr<const FlatGraph<qreal>> graph, reversed;
+        if (landmarks && landmarks->getVersion() == snapshot->getVersion()) {
+            graph = landmarks->sharedGraph();
+            reversed = landmarks->sharedReversed();
+        }
+
+        const int count = ROUTE_COUNT;
+        std::future<std::vector<Route>> result = std::async(std::launch::async, [snapshot, graph, reversed, fromId, toId, count]() {
+            KShortestPaths paths = graph ? KShortestPaths(graph, reversed) : KShortestPaths(*snapshot);
+            return paths.find(fromId, toId, count);
+        });
+
+        std::vector<Route> routes = waitForResult(result, RESULT_POLL_MS);
+        if (snapshot->getVersion() != model.getVersion()) return;
+
+        if (routes.empty()) {
+            showStatus("No route");
+            return;
+        }
+
+        highlightRoutes(fromId, toId, routes);
+        QStringList lengths;
+        for (const Route& route : routes) {
+            lengths.append(QString::number(route.length));
+        }
+
+        showStatus(QString("%1 shortest routes: %2").arg(routes.size()).arg(lengths.join(", ")));
+        return;
+    }
+
+    if (key == Qt::Key_Q) {
+        if (selectedVertices.size() != 2) return;
+
+        int fromId = selectedVertices[isShiftPressed];
+        int toId = selectedVertices[!isShiftPressed];
+        cancelDijkstra();
+        selectedEdges.clear();
+        deselectAllVertices();
+        resetInputState();
+
+        // Until landmarks for this version are ready the query runs without them
+        std::shared_ptr<const GraphSnapshot> snapshot = model.snapshot();
+        updateLandmarks(snapshot);
+        std::shared_ptr<const Landmarks> ready = landmarks && landmarks->getVersion() == snapshot->getVersion() ? landmarks : nullptr;
+
+        struct Answer {
+            bool isFound;
+            Route route;
+            size_t settled;
+            qint64 elapsedMs;
+        };
+        std::future<Answer> result = std::async(std::launch::async, [snapshot, ready, fromId, toId]() {
+            QElapsedTimer timer;
+            timer.start();
+            Answer answer;
+            if (ready) {
+                answer.isFound = ready->query(fromId, toId, answer.route, answer.settled);
+            }
+            else {
+                Landmarks plain;
+                plain.build(*snapshot, {}, 0);
+                answer.isFound = plain.query(fromId, toId, answer.route, answer.settled);
+            }
+            answer.elapsedMs = timer.elapsed();
+            return answer;
+        });
+
+        Answer answer = waitForResult(result, RESULT_POLL_MS);
+        if (snapshot->getVersion() != model.getVersion()) return;
+
+        if (!answer.isFound) {
+            showStatus("No route");
+            return;
+        }
+
+        highlightRoutes(fromId, toId, {answer.route});
+        showStatus(QString("Distance %1 in %2 ms, %3 of %4 vertices settled, %5")
+                       .arg(answer.route.length).arg(answer.elapsedMs).arg(answer.settled).arg(vertices.size())
+                       .arg(ready ? "with landmarks" : "landmarks still building"));
+        return;
+    }
+
+    if (key == Qt::Key_G) {
+        std::shared_ptr<const GraphSnapshot> snapshot = model.snapshot();
+        if (snapshot->vertexCount() > FloydWarshall::MAX_VERTICES) {
+            showStatus(QString("All-pairs distances need at most %1 vertices, the graph has %2")
+                           .arg(FloydWarshall::MAX_VERTICES).arg(snapshot->vertexCount()));
+            return;
+        }
+
+        std::future<DistanceMatrix> result = std::async(std::launch::async, [snapshot]() {
+            return FloydWarshall::run(*snapshot);
+        });
+
+        DistanceMatrix distances;
+        try {
+            distances = waitForResult(result, RESULT_POLL_MS);
+        }
+        catch (const std::bad_alloc &) {
+            showStatus("Not enough memory for all-pairs distances");
+            return;
+        }
+        if (snapshot->getVersion() != model.getVersion()) return;
+
+        allPairs = std::move(distances);
+        update();
+        return;
+    }
+
+    if (key == Qt::Key_O) {
+        QString path = QFileDialog::getOpenFileName(this, "Open graph", "", "Graph (*.txt)");
+        if (!path.isEmpty()) openGraph(path);
+        return;
+    }
+
+    if (key == Qt::Key_N) {
+        bool isAccepted = false;
+        QString spec = QInputDialog::getText(this, "Generate graph",
+                                             "<kind> <vertices> [edges] [seed=<n>] [weights=<distribution>]\n"
+                                             "kinds: rmat, grid, geometric, random, chain\n"
+                                             "distributions: uniform:<min>:<max>, real:<min>:<max>, exp:<mean>, length",
+                                             QLineEdit::Normal, generatorSpec, &isAccepted);
+        if (!isAccepted) return;
+
+        generatorSpec = spec;
+        generateGraph(spec);
+        return;
+    }
+
+    if (key == Qt::Key_S) {
+        saveGraph();
+        return;
+    }
+
+    if (key == Qt::Key_X) {
+        if (allPairs.isEmpty()) return;
+
+        exportAllPairs();
+        return;
+    }
+
+    if (key == Qt::Key_L) {
+        toggleLayout();
+        return;
+    }
+
+    if (key == Qt::Key_P) {
+        profiler.setEnabled(!profiler.isEnabled());
+
+        update();
+        return;
+    }
+
+    if (key == Qt::Key_I) {
+        if (isShiftPressed) saveMemoryReport();
+        else toggleMemoryReport();
+        return;
+    }
+
+    if (key == Qt::Key_M) {
+        isTiledRendering = !isTiledRendering;
+
+        update();
+        return;
+    }
+
+    if (key == Qt::Key_T) {
+        toggleTrace();
+        return;
+    }
+
+    if (key == Qt::Key_D) {
+        deselectAllVertices();
+
+        resetInputState();
+        update();
+        return;
+    }
+
+    if (key == Qt::Key_A) {
+        deselectAllVertices();
+
+        for (auto& [id, vertex] : vertices) {
+            selectVertex(id);
+        }
+
+        update();
+        return;
+    }
+
+    if (key == Qt::Key_Z) {
+        if (selectedVertices.size() < 2) return;
+
+        GraphTransaction transaction(this);
+        for (size_t i = 0; i < selectedVertices.size(); ++i) {
+            for (size_t j = i + 1; j < selectedVertices.size(); ++j) {
+                transaction.addEdge(selectedVertices[i], selectedVertices[j], 1);
+            }
+        }
+        transaction.commit();
+
+        resetInputState();
+        update();
+        return;
+    }
+
+    if (key == Qt::Key_Delete) {
+        if (selectedVertices.size() <= 0 && selectedEdges.size() <= 0) return;
+
+        GraphTransaction transaction(this);
+        for (int id : selectedEdges) {
+            transaction.removeEdge(id);
+        }
+        for (int id : selectedVertices) {
+            transaction.removeVertex(id);
+        }
+        transaction.commit();
+
+        selectedEdges.clear();
+        selectedVertices.clear();
+
+        resetInputState();
+        update();
+        return;
+    }
+
+    if (key == Qt::Key_Shift) {
+        isShiftPressed = true;
+        update();
+        return;
+    }
+}
+
+void Canvas::keyReleaseEvent(QKeyEvent *event) {
+    if (event->key() == Qt::Key_Shift) {
+        isShiftPressed = false;
+        update();
+    }
+}
@@ -1,137 +1,257 @@
-#ifndef CANVAS_H
-#define CANVAS_H
-
-#include "vertex.h"
-#include "edge.h"
-#include "Tools/tools.h"
-#include "Tools/selecttool.h"
-#include "Tools/pentool.h"
-#include "dijkstra.h"
-
-#include <vector>
-#include <unordered_map>
-
-#include <QMainWindow>
-
-typedef std::unordered_map<int, Vertex*> vertexMap;
-typedef std::unordered_map<int, Edge*> edgeMap;
-
-class Canvas : public QMainWindow  {
-    Q_OBJECT
-
-public:
-    Canvas(QWidget *parent = nullptr);
-
-    Vertex* getClickedVertex(QPointF clickPos);
-    Vertex* getVertex(int id) { return vertices.at(id); };
-    QPointF getScreenCenter() { return screenCenter; };
-    QPointF getTransformedPos(const QPointF& pos);
-    QPointF getAbsoluteCenter();
-    qreal getHalfScreenDiagonal() { return halfScreenDiagonal; };
-    void createVertex(QPointF pos, int radius);
-    void deselectAllVertices();
-    void selectVertex(int id);
-
-    const qreal EDGE_SELECTION_RANGE = 15;
-    const int VERTEX_RADIUS = 25;
-    QFont font = {"Latin Modern Math", 16};
-
-    vertexMap vertices;
-    edgeMap edges;
-    std::vector<int> selectedEdges;
-
-    std::vector<int> djCheckedEdges;
-    std::vector<int> djCheckedVertices;
-    vertexMap djEndAnimation;
-    int djStartVertex = -1;
-    int djEndVertex = -1;
-    int djCurrentVertex = -1;
-
-    qreal scaleFactor = 1.0;
-    QPointF offset = {0, 0};
-
-    qreal halfScreenDiagonal;
-    QPointF screenCenter;
-
-    Vertex* draggingVertex = nullptr;
-    QPointF draggingOffset;
-
-private:
-    int getNumFromArray(std::vector<int> array);
-    int getMinWeightVertex(std::vector<int> vertexIds);
-    void resetInputState();
-    void deselectFirstVertex();
-    void linkVertices(int firstId, int secondId, qreal weight);
-    void deleteEdge(int id);
-    void deleteVertex(int id);
-
-    void drawVertices(QPainter& painter);
-    void drawEdges(QPainter& painter);
-    void drawFakeEdges(QPainter& painter);
-    void drawGrid(QPainter& painter, const QPointF& center);
-    void drawTutorial(QPainter& painter);
-
-    void paintEvent(QPaintEvent *event) override;
-    void wheelEvent(QWheelEvent *event) override;
-    void mousePressEvent(QMouseEvent *event) override;
-    void mouseMoveEvent(QMouseEvent *event) override;
-    void mouseReleaseEvent(QMouseEvent *event) override;
-    void keyPressEvent(QKeyEvent *event) override;
-    void keyReleaseEvent(QKeyEvent *event) override;
-
-    void cancelDijkstra();
-    void visualizeDijkstra(const vertexMap &graphVertices, const Events &events, int startIteretion);
-
-    const QCursor PAN_CURSOR = Qt::ClosedHandCursor;
-    QFont textFont = {"Latin Modern Math", 13};
-    QStringList tutorialText = {
-        "Use middle mouse button for navigation",
-        "Place vertices using pen tool",
-        "Select two vertices and start typing to enter the weight between",
-        "Press \"Enter\" or \"E\" to confirm input",
-        "Press space to start entering weight in another direction",
-        "Press Delete to delete vertices or edges",
-        "Select vertex and Run Dijkstra algorithm",
-        "\"F\" - Run Dijkstra algorithm",
-        "\"V\" - Select Tool",
-        "\"B\" - Pen Tool",
-        "\"A\" - Select all",
-        "\"D\" - Deselect all"
-    };
-
-    const qreal ZOOM_OUT_LIMIT = 0.25;
-    const qreal LINE_THICKNESS = 5;
-    const qreal GRID_GAP = 16;
-    const int gridLightnes = 150;
-    const int GRID_DIVISON = 5;
-
-    const int STEP_DELAY_MS = 400;
-    const int START_DELAY_MS = 800;
-    const int EDGE_STEP_DELAY_MS = STEP_DELAY_MS / 2;
-    const int END_DELAY_MS = STEP_DELAY_MS / 4;
-    const int FLICK_DELAY_MS = STEP_DELAY_MS / 2;
-
-    int totalVertices = 0;
-    int totalEdges = 0;
-
-    std::vector<int> selectedVertices;
-
-    QPoint lastMousePos;
-
-    SelectTool *selectTool = new SelectTool(this);
-    PenTool *penTool = new PenTool(this);
-    Tools *currentTool = selectTool;
-
-    bool isShiftPressed = false;
-    Edge *fakeEdge = new Edge("", -1, 0, 0, 0, this);
-    bool isFirstLink = true;
-    std::vector<int> intPressed1;
-    std::vector<int> intPressed2;
-    int floatExponent1 = 0;
-    int floatExponent2 = 0;
-
-    bool isDijkstraRunning = false;
-    int iteretion = 0;
-};
-
-#endif // CANVAS_H
+#ifndef CANVAS_H
+#define CANVAS_H
+
+#include "vertex.h"
+#include "edge.h"
+#include "Tools/tools.h"
+#include "Tools/selecttool.h"
+#include "Tools/pentool.h"
+#include "dijkstra.h"
+#include "floydwarshall.h"
+#include "forcelayout.h"
+#include "graphtransaction.h"
+#include "graphloader.h"
+#include "graphgenerator.h"
+#include "graphsnapshot.h"
+#include "landmarks.h"
+#include "queryserver.h"
+#include "frameprofiler.h"
+#include "labelcache.h"
+#include "memoryreport.h"
+#include "drawbatch.h"
+#include "tiledrenderer.h"
+
+#include <future>
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <QMainWindow>
+#include <QTimer>
+
+typedef std::unordered_map<int, Vertex*> vertexMap;
+typedef std::unordered_map<int, Edge*> edgeMap;
+
+class Canvas : public QMainWindow  {
+    Q_OBJECT
+
+public:
+    Canvas(QWidget *parent = nullptr);
+
+    Vertex* getClickedVertex(QPointF clickPos);
+    Vertex* getVertex(int id) { return vertices.at(id); };
+    int findEdge(int startId, int endId) const;
+    bool hasEdge(int startId, int endId) const { return findEdge(startId, endId) != -1; };
+    QPointF getScreenCenter() { return screenCenter; };
+    QPointF getTransformedPos(const QPointF& pos);
+    QPointF getAbsoluteCenter();
+    qreal getHalfScreenDiagonal() { return halfScreenDiagonal; };
+    void createVertex(QPointF pos, int radius);
+    void deselectAllVertices();
+    void selectVertex(int id);
+    void applyTransaction(const GraphTransaction &transaction);
+    void openGraph(const QString &path);
+    void generateGraph(const QString &spec);
+    void startServer(const QString &path);
+    MemoryReport memoryReport() const;
+    void measureItems();
+
+    const qreal EDGE_SELECTION_RANGE = 15;
+    const int VERTEX_RADIUS = 25;
+    QFont font = {"Latin Modern Math", 16};
+
+    vertexMap vertices;
+    edgeMap edges;
+    std::unordered_map<uint64_t, int> edgeIndex;
+    GraphModel model;
+    std::vector<int> selectedEdges;
+
+    std::unordered_set<int> djCheckedEdges;
+    std::unordered_set<int> djCheckedVertices;
+    std::unordered_set<int> djEndAnimation;
+    int djStartVertex = -1;
+    int djEndVertex = -1;
+    int djCurrentVertex = -1;
+    // Bumped instead of clearing every vertex weight
+    int weightEpoch = 0;
+
+    DistanceMatrix allPairs;
+    // Rebuilt in the background after edits, see updateLandmarks
+    std::shared_ptr<const Landmarks> landmarks;
+    std::future<std::shared_ptr<const Landmarks>> landmarkBuild;
+    QueryServer server;
+    FrameProfiler profiler;
+    LabelCache labels;
+    bool isTiledRendering = false;
+
+    qreal scaleFactor = 1.0;
+    QPointF offset = {0, 0};
+
+    qreal halfScreenDiagonal;
+    QPointF screenCenter;
+    bool isPartialPaint = false;
+    QRectF paintBounds;
+
+    Vertex* draggingVertex = nullptr;
+    QPointF draggingOffset;
+
+private:
+    friend class GraphTransaction;
+
+    int getNumFromArray(std::vector<int> array);
+    int getMinWeightVertex(std::vector<int> vertexIds);
+    void resetInputState();
+    void deselectFirstVertex();
+    void linkVertices(int firstId, int secondId, qreal weight);
+    void attachEdge(Edge *edge);
+    void detachEdge(Edge *edge);
+    void moveVertex(Vertex *vertex, QPointF pos);
+    void graphChanged();
+    void updateScene(const QRectF& sceneRect);
+    QRectF vertexBounds(int id, bool withEdges = false);
+    QRectF edgeBounds(int id);
+    QRectF linkPreviewBounds();
+
+    void drawVertices(QPainter& painter);
+    void drawEdges(QPainter& painter);
+    void drawFakeEdges(QPainter& painter);
+    void drawGrid(QPainter& painter, const QPointF& center);
+    void drawTutorial(QPainter& painter);
+    void drawAllPairs(QPainter& painter);
+    void drawOverlays(QPainter& painter);
+    void submitLayer(QPainter& painter, DrawBatch& batch);
+
+    void paintEvent(QPaintEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void keyPressEvent(QKeyEvent *event) override;
+    void keyReleaseEvent(QKeyEvent *event) override;
+
+    void cancelDijkstra();
+    void visualizeDijkstra(const std::unordered_set<int> &graphVertices, const Events &events, int startIteretion);
+    void exportAllPairs();
+    void toggleTrace();
+    void toggleLayout();
+    void stopLayout();
+    void applyLayout();
+    void beginLoading();
+    void applyLoadedBatch();
+    void saveGraph();
+    void showStatus(const QString &text);
+    void drawStatus(QPainter& painter);
+    void highlightRoutes(int fromId, int toId, const std::vector<Route> &routes);
+    void updateLandmarks(const std::shared_ptr<const GraphSnapshot> &snapshot);
+    void toggleMemoryReport();
+    void saveMemoryReport();
+
+    const QCursor PAN_CURSOR = Qt::ClosedHandCursor;
+    QFont textFont = {"Latin Modern Math", 13};
+    QStringList tutorialText = {
+        "Use middle mouse button for navigation",
+        "Place vertices using pen tool",
+        "Select two vertices and start typing to enter the weight between",
+        "Press \"Enter\" or \"E\" to confirm input",
+        "Press space to start entering weight in another direction",
+        "Press Delete to delete vertices or edges",
+        "Select vertex and Run Dijkstra algorithm",
+        "\"F\" - Run Dijkstra algorithm",
+        "\"R\" - Select everything reachable from the selection",
+        "\"K\" - Highlight the shortest routes between two selected vertices",
+        "\"Q\" - Query the shortest route between two selected vertices with landmarks",
+        "\"G\" - Compute all-pairs distances, select two vertices to query",
+        "\"X\" - Export all-pairs distances",
+        "\"L\" - Start or stop automatic layout",
+        "\"P\" - Show or hide the frame profiler",
+        "\"T\" - Start recording a trace, press again to save it",
+        "\"M\" - Toggle multithreaded tiled rendering",
+        "\"I\" - Show or hide memory usage, Shift+I to save it",
+        "\"O\" - Open a graph file, \"S\" - Save the graph",
+        "\"N\" - Generate a synthetic graph",
+        "\"V\" - Select Tool",
+        "\"B\" - Pen Tool",
+        "\"A\" - Select all",
+        "\"D\" - Deselect all"
+    };
+
+    const qreal ZOOM_OUT_LIMIT = 0.25;
+    const qreal LINE_THICKNESS = 5;
+    const qreal GRID_GAP = 16;
+    const int gridLightnes = 150;
+    const int GRID_DIVISON = 5;
+    const int PROFILER_WIDTH = 330;
+    const int MEMORY_WIDTH = 330;
+    const qreal FAKE_EDGE_OPACITY = 0.3;
+
+    const int STEP_DELAY_MS = 400;
+    const int START_DELAY_MS = 800;
+    const int EDGE_STEP_DELAY_MS = STEP_DELAY_MS / 2;
+    const int END_DELAY_MS = STEP_DELAY_MS / 4;
+    const int FLICK_DELAY_MS = STEP_DELAY_MS / 2;
+    const int LAYOUT_FRAME_MS = 16;
+    const int RESULT_POLL_MS = 5;
+    const int LOAD_FRAME_MS = 16;
+    const int STATUS_MS = 5000;
+    const int MEMORY_REFRESH_MS = 1000;
+    const int ROUTE_COUNT = 5;
+
+    int totalVertices = 0;
+    int totalEdges = 0;
+
+    std::vector<int> selectedVertices;
+
+    QPoint lastMousePos;
+
+    SelectTool *selectTool = new SelectTool(this);
+    PenTool *penTool = new PenTool(this);
+    Tools *currentTool = selectTool;
+
+    bool isShiftPressed = false;
+    Edge *fakeEdge = new Edge("", -1, 0, 0, 0, this);
+    bool isFirstLink = true;
+    std::vector<int> intPressed1;
+    std::vector<int> intPressed2;
+    int floatExponent1 = 0;
+    int floatExponent2 = 0;
+
+    DrawBatch gridBatch;
+    DrawBatch edgeBatch;
+    DrawBatch fakeEdgeBatch;
+    DrawBatch vertexBatch;
+    TiledRenderer tiledRenderer;
+
+    ForceLayout forceLayout;
+    QTimer *layoutTimer = new QTimer(this);
+
+    GraphLoader loader;
+    QTimer *loadTimer = new QTimer(this);
+    std::vector<int> loadedIds;
+    bool isLoading = false;
+    QString generatorSpec = "geometric 10000 seed=1 weights=length";
+
+    QString statusText;
+    QTimer *statusTimer = new QTimer(this);
+
+    // Refreshed on a timer, walking every vertex each frame would cost more than drawing them
+    MemoryReport memory;
+
+    // The parts that walk every vertex and edge, measured again only when
+    // the graph version changes or the report is shown or saved
+    struct ItemMemory {
+        int version = -1;
+        size_t vertexStrings = 0;
+        size_t adjacency = 0;
+        size_t adjacencyEntries = 0;
+        size_t edgeStrings = 0;
+        size_t model = 0;
+    };
+    ItemMemory itemMemory;
+    QTimer *memoryTimer = new QTimer(this);
+    const Events *activeEvents = nullptr;
+
+    int iteretion = 0;
+};
+
+#endif // CANVAS_H
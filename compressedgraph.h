@@ -0,0 +1,185 @@
+#ifndef COMPRESSEDGRAPH_H
+#define COMPRESSEDGRAPH_H
+
+#include "flatgraph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+// Read-only adjacency for very large graphs, with the same interface as
+// FlatGraph. Each vertex's out-edges are sorted by target and stored as
+// varints: the gap to the previous target, an index into a table of the
+// distinct weights (most frequent first, so common weights take one byte)
+// and the difference to the previous edge id. The table holds at most
+// MAX_WEIGHT_CODES weights; rarer ones follow an escape code as raw bytes,
+// so every weight stays exact. Edge ids start from 0 at each vertex and
+// follow target order, so they only shrink when a vertex's edges were
+// created together; otherwise they cost their full varint width.
+// forEachOut decodes on the fly.
+template <typename WeightType>
+class CompressedGraph {
+
+public:
+    typedef WeightType Weight;
+    typedef WeightTraits<Weight> Traits;
+
+    CompressedGraph(const GraphSnapshot &graph, const std::vector<int> &order = {}) {
+        ids.reserve(graph.vertexCount());
+        index.assign(graph.vertexIdBound(), -1);
+        if (order.empty()) {
+            graph.forEachVertex([&](const VertexRecord &vertex) {
+                ids.push_back(vertex.id);
+            });
+        }
+        else {
+            ids = order;
+        }
+
+        for (size_t i = 0; i < ids.size(); ++i) {
+            index[ids[i]] = i;
+        }
+
+        std::unordered_map<qreal, uint32_t> codes = buildWeightTable(graph);
+
+        offsets.reserve(ids.size() + 1);
+        offsets.push_back(0);
+        edges = 0;
+
+        std::vector<std::tuple<int, uint32_t, int>> out;
+        for (size_t i = 0; i < ids.size(); ++i) {
+            const VertexRecord *vertex = graph.vertex(ids[i]);
+
+            out.clear();
+            for (int edgeId : vertex->out.edgeId) {
+                const EdgeRecord *edge = graph.edge(edgeId);
+                auto code = codes.find(edge->weight);
+                out.emplace_back(index[edge->endId], code != codes.end() ? code->second : INLINE_CODE, edgeId);
+            }
+            std::sort(out.begin(), out.end());
+
+            int64_t previousTarget = i;
+            int64_t previousEdgeId = 0;
+            for (const auto& [target, code, edgeId] : out) {
+                writeVarint(zigzag(target - previousTarget));
+                writeVarint(code);
+                if (code == INLINE_CODE) writeWeight(Weight(graph.edge(edgeId)->weight));
+                writeVarint(zigzag(edgeId - previousEdgeId));
+                previousTarget = target;
+                previousEdgeId = edgeId;
+            }
+
+            edges += out.size();
+            offsets.push_back(bytes.size());
+        }
+
+        bytes.shrink_to_fit();
+    }
+
+    static bool canRepresent(const GraphSnapshot &graph) { return FlatGraph<Weight>::canRepresent(graph); }
+
+    static constexpr uint32_t MAX_WEIGHT_CODES = 1 << 16;
+    static constexpr uint32_t INLINE_CODE = MAX_WEIGHT_CODES;
+
+    int size() const { return ids.size(); }
+    size_t edgeCount() const { return edges; }
+    int indexOf(int id) const { return id >= 0 && size_t(id) < index.size() ? index[id] : -1; }
+    int idAt(int vertex) const { return ids[vertex]; }
+    Weight getMaxWeight() const { return maxWeight; }
+
+    size_t memoryUsage() const {
+        return ids.capacity() * sizeof(int) + index.capacity() * sizeof(int) + offsets.capacity() * sizeof(uint64_t)
+             + bytes.capacity() + weightTable.capacity() * sizeof(Weight);
+    }
+
+    // Calls function(target, weight, edgeId) for every outgoing edge
+    template <typename Function>
+    void forEachOut(int vertex, const Function& function) const {
+        const uint8_t *data = bytes.data() + offsets[vertex];
+        const uint8_t *end = bytes.data() + offsets[vertex + 1];
+
+        int64_t target = vertex;
+        int64_t edgeId = 0;
+        while (data < end) {
+            target += unzigzag(readVarint(data));
+            uint64_t code = readVarint(data);
+            Weight weight = code != INLINE_CODE ? weightTable[code] : readWeight(data);
+            edgeId += unzigzag(readVarint(data));
+            function(int(target), weight, int(edgeId));
+        }
+    }
+
+private:
+    std::unordered_map<qreal, uint32_t> buildWeightTable(const GraphSnapshot &graph) {
+        std::unordered_map<qreal, size_t> counts;
+        graph.forEachEdge([&](const EdgeRecord &edge) {
+            ++counts[edge.weight];
+        });
+
+        std::vector<std::pair<size_t, qreal>> byCount;
+        byCount.reserve(counts.size());
+        for (const auto& [weight, count] : counts) {
+            byCount.push_back({count, weight});
+        }
+        std::sort(byCount.begin(), byCount.end(), [](const auto& a, const auto& b) {
+            return a.first != b.first ? a.first > b.first : a.second < b.second;
+        });
+
+        std::unordered_map<qreal, uint32_t> codes;
+        maxWeight = 0;
+        for (const auto& [count, weight] : byCount) {
+            if (weightTable.size() < MAX_WEIGHT_CODES) {
+                codes.insert({weight, uint32_t(weightTable.size())});
+                weightTable.push_back(Weight(weight));
+            }
+            maxWeight = std::max(maxWeight, Weight(weight));
+        }
+        return codes;
+    }
+
+    static uint64_t zigzag(int64_t value) { return (uint64_t(value) << 1) ^ uint64_t(value >> 63); }
+    static int64_t unzigzag(uint64_t value) { return int64_t(value >> 1) ^ -int64_t(value & 1); }
+
+    void writeVarint(uint64_t value) {
+        while (value >= 0x80) {
+            bytes.push_back(uint8_t(value) | 0x80);
+            value >>= 7;
+        }
+        bytes.push_back(uint8_t(value));
+    }
+
+    void writeWeight(Weight weight) {
+        uint8_t raw[sizeof(Weight)];
+        std::memcpy(raw, &weight, sizeof(Weight));
+        bytes.insert(bytes.end(), raw, raw + sizeof(Weight));
+    }
+
+    static Weight readWeight(const uint8_t *&data) {
+        Weight weight;
+        std::memcpy(&weight, data, sizeof(Weight));
+        data += sizeof(Weight);
+        return weight;
+    }
+
+    static uint64_t readVarint(const uint8_t *&data) {
+        uint64_t value = 0;
+        for (int shift = 0; ; shift += 7) {
+            uint8_t byte = *data++;
+            value |= uint64_t(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return value;
+        }
+    }
+
+    std::vector<int> ids;
+    std::vector<int> index;
+    std::vector<uint64_t> offsets;
+    std::vector<uint8_t> bytes;
+    std::vector<Weight> weightTable;
+    size_t edges;
+    Weight maxWeight;
+};
+
+#endif // COMPRESSEDGRAPH_H
@@ -0,0 +1,115 @@
+#include "densegraph.h"
+
+#include <limits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define DENSE_SSE2
+#endif
+
+// Keys hold tentative distances: +inf for undiscovered vertices and NaN for
+// settled ones and padding. Every comparison against NaN is false, so settled
+// vertices are skipped by both kernels without a separate mask.
+static const qreal INF_WEIGHT = std::numeric_limits<qreal>::infinity();
+static const qreal SETTLED = std::numeric_limits<qreal>::quiet_NaN();
+
+DenseGraph::DenseGraph(const GraphSnapshot &graph, const std::vector<int> &vertexIds) {
+    count = vertexIds.size();
+    stride = (count + LANES - 1) / LANES * LANES;
+
+    ids = vertexIds;
+    index.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        index.insert({ids[i], i});
+    }
+
+    weights.assign(size_t(stride) * stride, INF_WEIGHT);
+    edgeIds.assign(size_t(stride) * stride, -1);
+
+    for (int id : ids) {
+        const VertexRecord *vertex = graph.vertex(id);
+        size_t from = index.at(id);
+        for (size_t i = 0; i < vertex->out.vertexId.size(); ++i) {
+            auto to = index.find(vertex->out.vertexId[i]);
+            if (to == index.end()) continue;
+
+            int edgeId = vertex->out.edgeId[i];
+            weights[from * stride + to->second] = graph.edge(edgeId)->weight;
+            edgeIds[from * stride + to->second] = edgeId;
+        }
+    }
+}
+
+bool DenseGraph::isDense(size_t vertexCount, size_t edgeCount) {
+    if (vertexCount < 2) return false;
+    return edgeCount >= DENSITY_THRESHOLD * vertexCount * vertexCount;
+}
+
+std::vector<qreal> DenseGraph::createKeys() const {
+    std::vector<qreal> keys(stride, SETTLED);
+    std::fill(keys.begin(), keys.begin() + count, INF_WEIGHT);
+    return keys;
+}
+
+int DenseGraph::selectMin(const qreal *keys) const {
+    qreal minKey = INF_WEIGHT;
+
+#if defined(__AVX2__)
+    __m256d best = _mm256_set1_pd(INF_WEIGHT);
+    for (int i = 0; i < stride; i += 4) {
+        best = _mm256_min_pd(_mm256_loadu_pd(keys + i), best);
+    }
+    __m128d half = _mm_min_pd(_mm256_castpd256_pd128(best), _mm256_extractf128_pd(best, 1));
+    minKey = _mm_cvtsd_f64(_mm_min_sd(half, _mm_unpackhi_pd(half, half)));
+#elif defined(DENSE_SSE2)
+    __m128d best = _mm_set1_pd(INF_WEIGHT);
+    for (int i = 0; i < stride; i += 2) {
+        best = _mm_min_pd(_mm_loadu_pd(keys + i), best);
+    }
+    minKey = _mm_cvtsd_f64(_mm_min_sd(best, _mm_unpackhi_pd(best, best)));
+#else
+    for (int i = 0; i < count; ++i) {
+        if (keys[i] < minKey) minKey = keys[i];
+    }
+#endif
+
+    if (minKey == INF_WEIGHT) return -1;
+
+    for (int i = 0; i < count; ++i) {
+        if (keys[i] == minKey) return i;
+    }
+    return -1;
+}
+
+void DenseGraph::settle(qreal *keys, int i) const {
+    keys[i] = SETTLED;
+}
+
+void DenseGraph::relaxRow(int from, qreal distance, qreal *keys) const {
+    const qreal *weightRow = row(from);
+
+#if defined(__AVX2__)
+    __m256d dist = _mm256_set1_pd(distance);
+    for (int i = 0; i < stride; i += 4) {
+        __m256d key = _mm256_loadu_pd(keys + i);
+        __m256d candidate = _mm256_add_pd(dist, _mm256_loadu_pd(weightRow + i));
+        __m256d shorter = _mm256_cmp_pd(candidate, key, _CMP_LT_OQ);
+        _mm256_storeu_pd(keys + i, _mm256_blendv_pd(key, candidate, shorter));
+    }
+#elif defined(DENSE_SSE2)
+    __m128d dist = _mm_set1_pd(distance);
+    for (int i = 0; i < stride; i += 2) {
+        __m128d key = _mm_loadu_pd(keys + i);
+        __m128d candidate = _mm_add_pd(dist, _mm_loadu_pd(weightRow + i));
+        __m128d shorter = _mm_cmplt_pd(candidate, key);
+        _mm_storeu_pd(keys + i, _mm_or_pd(_mm_and_pd(shorter, candidate), _mm_andnot_pd(shorter, key)));
+    }
+#else
+    for (int i = 0; i < count; ++i) {
+        qreal candidate = distance + weightRow[i];
+        if (candidate < keys[i]) keys[i] = candidate;
+    }
+#endif
+}
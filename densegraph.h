@@ -0,0 +1,42 @@
+#ifndef DENSEGRAPH_H
+#define DENSEGRAPH_H
+
+#include "graphsnapshot.h"
+
+#include <unordered_map>
+#include <vector>
+
+// Adjacency matrix of a (sub)graph. Rows are padded to a multiple of the
+// widest vector lane so the kernels below never need a scalar tail.
+class DenseGraph {
+
+public:
+    DenseGraph(const GraphSnapshot &graph, const std::vector<int> &vertexIds);
+
+    static bool isDense(size_t vertexCount, size_t edgeCount);
+
+    int size() const { return count; }
+    int getStride() const { return stride; }
+    int indexOf(int vertexId) const { return index.at(vertexId); }
+    int idAt(int i) const { return ids[i]; }
+    int edgeAt(int from, int to) const { return edgeIds[size_t(from) * stride + to]; }
+    const qreal* row(int i) const { return weights.data() + size_t(i) * stride; }
+
+    std::vector<qreal> createKeys() const;
+    int selectMin(const qreal *keys) const;
+    void settle(qreal *keys, int i) const;
+    void relaxRow(int from, qreal distance, qreal *keys) const;
+
+    static constexpr qreal DENSITY_THRESHOLD = 0.25;
+    static constexpr int LANES = 4;
+
+private:
+    int count;
+    int stride;
+    std::vector<int> ids;
+    std::unordered_map<int, int> index;
+    std::vector<qreal> weights;
+    std::vector<int> edgeIds;
+};
+
+#endif // DENSEGRAPH_H
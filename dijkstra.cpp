@@ -1,110 +1,275 @@
-#include "utils.h"
-#include "dijkstra.h"
-
-void Dijkstra::logEvent(Events &events, EventName name, int vertexId, int edgeId, qreal weight) {
-    events.emplace_back(Event{name, vertexId, edgeId, weight});
-}
-
-int getMinWeightVertex(std::vector<int> vertexIds, vertexMap vertices) {
-    int minId = vertexIds[0];
-    qreal minWeight = vertices.at(minId)->weight;
-
-    for (int id : vertexIds) {
-        qreal weight = vertices.at(id)->weight;
-
-        if (weight != INF && weight < minWeight) {
-            minWeight = weight;
-            minId = id;
-        }
-    }
-
-    return (minWeight == INF || minWeight == UNDEFINED) ? INF : minId;
-}
-
-void Dijkstra::weightsToInf(Vertex& startVertex, vertexMap vertices, std::vector<int>& unchecked, Events &events) {
-    unchecked.push_back(startVertex.id);
-    startVertex.weight = INF;
-    logEvent(events, SET_WEIGHT, startVertex.id, UNDEFINED, INF);
-
-    for (int id : startVertex.out.vertexId) {
-        if (!utils::contains(unchecked, id)) {
-            Vertex *vertex = vertices.at(id);
-            weightsToInf(*vertex, vertices, unchecked, events);
-        }
-    }
-}
-
-int Dijkstra::dijkstraAlgorithm(Vertex &startVertex, vertexMap vertices, edgeMap edges,
-                                std::vector<int>& checkedEdges, std::vector<int>& unchecked,
-                                std::vector<int>& checked, Events &events) {
-    int currentVertex = startVertex.id;
-
-    // Process incoming edges
-    for (int id : startVertex.in.edgeId) {
-        if (utils::contains(checkedEdges, id) || !utils::contains(checked, edges.at(id)->startId)) continue;
-
-        checkedEdges.push_back(id);
-        logEvent(events, CHECK_EDGE, UNDEFINED, id, UNDEFINED);
-    }
-
-    logEvent(events, SET_CURRENT_VERTEX, currentVertex, UNDEFINED, UNDEFINED);
-
-    // Process neighboring vertices
-    for (size_t i = 0; i < startVertex.out.vertexId.size(); ++i) {
-        Vertex *vertex = vertices.at(startVertex.out.vertexId[i]);
-        Edge *edge = edges.at(startVertex.out.edgeId[i]);
-
-        if (!utils::contains(checkedEdges, edge->id)) {
-            checkedEdges.push_back(edge->id);
-            logEvent(events, CHECK_EDGE, UNDEFINED, edge->id, UNDEFINED);
-        }
-
-        if (utils::contains(unchecked, vertex->id)) {
-            logEvent(events, CHECK_VERTEX, vertex->id, UNDEFINED, UNDEFINED);
-            checked.push_back(vertex->id);
-
-            qreal distToVertex = startVertex.weight + edge->weight;
-            if (vertex->weight > distToVertex || vertex->weight == INF) {
-                vertex->weight = distToVertex;
-                logEvent(events, SET_WEIGHT, vertex->id, UNDEFINED, distToVertex);
-            }
-
-            checked.pop_back();
-            checkedEdges.pop_back();
-            logEvent(events, UNCHECK_VERTEX, vertex->id, UNDEFINED, UNDEFINED);
-            logEvent(events, UNCHECK_EDGE, UNDEFINED, edge->id, UNDEFINED);
-        }
-    }
-
-    checked.push_back(currentVertex);
-    unchecked.erase(std::remove(unchecked.begin(), unchecked.end(), currentVertex), unchecked.end());
-    logEvent(events, CHECK_VERTEX, currentVertex, UNDEFINED, UNDEFINED);
-
-    // Select next vertex
-    while (unchecked.size() != 0) {
-        int nextId = getMinWeightVertex(unchecked, vertices);
-        if (nextId == INF) break;
-
-        Vertex* nextVertex = vertices.at(nextId);
-        currentVertex = dijkstraAlgorithm(*nextVertex, vertices, edges, checkedEdges, unchecked, checked, events);
-    }
-
-    return currentVertex;
-}
-
-Events Dijkstra::run(Vertex &startVertex, vertexMap vertices, edgeMap edges) {
-    Events events;
-    std::vector<int> unchecked, checked, checkedEdges;
-
-    weightsToInf(startVertex, vertices, unchecked, events);
-    startVertex.weight = 0;
-
-    logEvent(events, SET_START_VERTEX, startVertex.id, UNDEFINED, UNDEFINED);
-    logEvent(events, SET_WEIGHT, startVertex.id, UNDEFINED, 0);
-
-    int lastVertex = dijkstraAlgorithm(startVertex, vertices, edges, checkedEdges, unchecked, checked, events);
-
-    logEvent(events, SET_END_VERTEX, lastVertex, UNDEFINED, UNDEFINED);
-
-    return events;
-}
+#include "utils.h"
+#include "dijkstra.h"
+#include "compressedgraph.h"
+#include "densegraph.h"
+#include "reachability.h"
+#include "shortestpath.h"
+#include "trace.h"
+
+void Dijkstra::logEvent(Events &events, EventName name, int vertexId, int edgeId, qreal weight) {
+    events.emplace_back(Event{name, vertexId, edgeId, weight});
+}
+
+int getMinWeightVertex(const std::vector<int> &vertexIds, const weightMap &weights) {
+    int minId = INF;
+    qreal minWeight = INF;
+
+    for (int id : vertexIds) {
+        qreal weight = weights.at(id);
+        if (weight == INF || weight == UNDEFINED) continue;
+
+        if (minId == INF || weight < minWeight) {
+            minWeight = weight;
+            minId = id;
+        }
+    }
+
+    return minId;
+}
+
+int Dijkstra::dijkstraAlgorithm(const GraphSnapshot &graph, int vertexId, weightMap &weights,
+                                std::vector<int>& checkedEdges, std::vector<int>& unchecked,
+                                std::vector<int>& checked, Events &events) {
+    const VertexRecord &startVertex = *graph.vertex(vertexId);
+    int currentVertex = vertexId;
+
+    // Process incoming edges
+    for (int id : startVertex.in.edgeId) {
+        if (utils::contains(checkedEdges, id) || !utils::contains(checked, graph.edge(id)->startId)) continue;
+
+        checkedEdges.push_back(id);
+        logEvent(events, CHECK_EDGE, UNDEFINED, id, UNDEFINED);
+    }
+
+    logEvent(events, SET_CURRENT_VERTEX, currentVertex, UNDEFINED, UNDEFINED);
+
+    // Process neighboring vertices
+    for (size_t i = 0; i < startVertex.out.vertexId.size(); ++i) {
+        int neighbourId = startVertex.out.vertexId[i];
+        const EdgeRecord *edge = graph.edge(startVertex.out.edgeId[i]);
+
+        if (!utils::contains(checkedEdges, edge->id)) {
+            checkedEdges.push_back(edge->id);
+            logEvent(events, CHECK_EDGE, UNDEFINED, edge->id, UNDEFINED);
+        }
+
+        if (utils::contains(unchecked, neighbourId)) {
+            logEvent(events, CHECK_VERTEX, neighbourId, UNDEFINED, UNDEFINED);
+            checked.push_back(neighbourId);
+
+            qreal& neighbourWeight = weights.at(neighbourId);
+            qreal distToVertex = weights.at(vertexId) + edge->weight;
+            if (neighbourWeight > distToVertex || neighbourWeight == INF) {
+                neighbourWeight = distToVertex;
+                logEvent(events, SET_WEIGHT, neighbourId, UNDEFINED, distToVertex);
+            }
+
+            checked.pop_back();
+            checkedEdges.pop_back();
+            logEvent(events, UNCHECK_VERTEX, neighbourId, UNDEFINED, UNDEFINED);
+            logEvent(events, UNCHECK_EDGE, UNDEFINED, edge->id, UNDEFINED);
+        }
+    }
+
+    checked.push_back(currentVertex);
+    unchecked.erase(std::remove(unchecked.begin(), unchecked.end(), currentVertex), unchecked.end());
+    logEvent(events, CHECK_VERTEX, currentVertex, UNDEFINED, UNDEFINED);
+
+    // Select next vertex
+    while (unchecked.size() != 0) {
+        int nextId = getMinWeightVertex(unchecked, weights);
+        if (nextId == INF) break;
+
+        currentVertex = dijkstraAlgorithm(graph, nextId, weights, checkedEdges, unchecked, checked, events);
+    }
+
+    return currentVertex;
+}
+
+int Dijkstra::runDense(const GraphSnapshot &snapshot, int startId, const std::vector<int> &vertexIds, Events &events) {
+    DenseGraph graph(snapshot, vertexIds);
+    std::vector<qreal> keys = graph.createKeys();
+    std::vector<bool> checked(graph.size(), false);
+
+    keys[graph.indexOf(startId)] = 0;
+    int lastVertex = startId;
+
+    while (true) {
+        int current = graph.selectMin(keys.data());
+        if (current == -1) break;
+
+        qreal distance = keys[current];
+        lastVertex = graph.idAt(current);
+
+        // Process incoming edges
+        for (int from = 0; from < graph.size(); ++from) {
+            int edgeId = graph.edgeAt(from, current);
+            if (edgeId == -1 || !checked[from]) continue;
+
+            logEvent(events, CHECK_EDGE, UNDEFINED, edgeId, UNDEFINED);
+        }
+
+        logEvent(events, SET_CURRENT_VERTEX, lastVertex, UNDEFINED, UNDEFINED);
+
+        // Process neighboring vertices
+        const qreal *weights = graph.row(current);
+        for (int to = 0; to < graph.size(); ++to) {
+            int edgeId = graph.edgeAt(current, to);
+            if (edgeId == -1) continue;
+
+            logEvent(events, CHECK_EDGE, UNDEFINED, edgeId, UNDEFINED);
+            if (checked[to]) continue;
+
+            int vertexId = graph.idAt(to);
+            logEvent(events, CHECK_VERTEX, vertexId, UNDEFINED, UNDEFINED);
+
+            qreal distToVertex = distance + weights[to];
+            if (distToVertex < keys[to]) {
+                logEvent(events, SET_WEIGHT, vertexId, UNDEFINED, distToVertex);
+            }
+
+            logEvent(events, UNCHECK_VERTEX, vertexId, UNDEFINED, UNDEFINED);
+            logEvent(events, UNCHECK_EDGE, UNDEFINED, edgeId, UNDEFINED);
+        }
+
+        graph.relaxRow(current, distance, keys.data());
+        graph.settle(keys.data(), current);
+        checked[current] = true;
+        logEvent(events, CHECK_VERTEX, lastVertex, UNDEFINED, UNDEFINED);
+    }
+
+    return lastVertex;
+}
+
+// Final distances only, as runEngine, with the matrix kernels doing the
+// search. Tree edges are recovered afterwards: a vertex's parent is the first
+// vertex settled before it whose row reproduces its distance exactly
+int Dijkstra::runDenseEngine(const GraphSnapshot &snapshot, int startId, const std::vector<int> &vertexIds, Events &events) {
+    DenseGraph graph(snapshot, vertexIds);
+    std::vector<qreal> keys = graph.createKeys();
+    std::vector<qreal> distances(graph.size());
+    std::vector<int> order;
+
+    keys[graph.indexOf(startId)] = 0;
+    while (true) {
+        int current = graph.selectMin(keys.data());
+        if (current == -1) break;
+
+        distances[current] = keys[current];
+        order.push_back(current);
+        graph.relaxRow(current, distances[current], keys.data());
+        graph.settle(keys.data(), current);
+    }
+
+    std::vector<int> parentEdge(graph.size(), -1);
+    for (size_t i = 0; i < order.size(); ++i) {
+        const int from = order[i];
+        const qreal *weights = graph.row(from);
+        for (size_t j = i + 1; j < order.size(); ++j) {
+            int to = order[j];
+            if (parentEdge[to] == -1 && graph.edgeAt(from, to) != -1 && distances[from] + weights[to] == distances[to]) {
+                parentEdge[to] = graph.edgeAt(from, to);
+            }
+        }
+    }
+
+    for (int vertex : order) {
+        if (parentEdge[vertex] != -1) logEvent(events, CHECK_EDGE, UNDEFINED, parentEdge[vertex], UNDEFINED);
+        logEvent(events, SET_WEIGHT, graph.idAt(vertex), UNDEFINED, distances[vertex]);
+    }
+
+    return order.empty() ? startId : graph.idAt(order.back());
+}
+
+// Final distances only: the shortest-path tree edges and one weight per vertex
+template <typename Graph>
+int Dijkstra::runEngine(const Graph &graph, int startId, Events &events) {
+    PathTree<typename Graph::Weight> tree;
+    ShortestPath<Graph>::run(graph, graph.indexOf(startId), tree);
+
+    for (int vertex : tree.order) {
+        if (tree.parentEdge[vertex] != -1) logEvent(events, CHECK_EDGE, UNDEFINED, tree.parentEdge[vertex], UNDEFINED);
+        logEvent(events, SET_WEIGHT, graph.idAt(vertex), UNDEFINED, tree.distance[vertex]);
+    }
+
+    return tree.order.empty() ? startId : graph.idAt(tree.order.back());
+}
+
+template <typename Weight>
+int Dijkstra::runFlat(const GraphSnapshot &snapshot, int startId, Events &events) {
+    if (snapshot.edgeCount() > COMPRESSION_EDGE_LIMIT) return runEngine(CompressedGraph<Weight>(snapshot), startId, events);
+    return runEngine(FlatGraph<Weight>(snapshot), startId, events);
+}
+
+int Dijkstra::runFlat(const GraphSnapshot &graph, int startId, Events &events) {
+    // Narrowest weight type that holds every weight and path length exactly
+    if (FlatGraph<uint32_t>::canRepresent(graph)) return runFlat<uint32_t>(graph, startId, events);
+    if (FlatGraph<float>::canRepresent(graph)) return runFlat<float>(graph, startId, events);
+    return runFlat<double>(graph, startId, events);
+}
+
+size_t Dijkstra::outEdgeCount(const GraphSnapshot &graph, const std::vector<int> &vertexIds) {
+    size_t edgeCount = 0;
+    for (int id : vertexIds) {
+        edgeCount += graph.vertex(id)->out.vertexId.size();
+    }
+    return edgeCount;
+}
+
+Events Dijkstra::run(const GraphSnapshot &graph, int startId) {
+    TRACE_SCOPE("Dijkstra::run");
+    Events events;
+    weightMap weights;
+    std::vector<int> unchecked, checked, checkedEdges;
+
+    // Large sparse runs only need the engine's own graph, so no reachability
+    // index is built next to it; their events list every reached vertex anyway
+    unchecked = Reachability::firstFrom(graph, startId, ANIMATION_LIMIT + 1);
+    if (unchecked.size() > ANIMATION_LIMIT) {
+        logEvent(events, SET_START_VERTEX, startId, UNDEFINED, UNDEFINED);
+
+        // Without enough edges for a dense part this large, collecting the
+        // whole reachable set is not worth it. On dense graphs the parallel
+        // search gains most from its bottom-up levels and its index is small
+        // next to the matrix
+        if (DenseGraph::isDense(unchecked.size(), graph.edgeCount())) {
+            unchecked = Reachability(graph).from(startId);
+        }
+
+        int lastVertex;
+        if (DenseGraph::isDense(unchecked.size(), outEdgeCount(graph, unchecked))) {
+            TRACE_SCOPE("Dijkstra::runDenseEngine");
+            lastVertex = runDenseEngine(graph, startId, unchecked, events);
+        }
+        else {
+            TRACE_SCOPE("Dijkstra::runFlat");
+            lastVertex = runFlat(graph, startId, events);
+        }
+
+        logEvent(events, SET_END_VERTEX, lastVertex, UNDEFINED, UNDEFINED);
+        return events;
+    }
+
+    for (int id : unchecked) {
+        weights[id] = INF;
+        logEvent(events, SET_WEIGHT, id, UNDEFINED, INF);
+    }
+    weights[startId] = 0;
+
+    logEvent(events, SET_START_VERTEX, startId, UNDEFINED, UNDEFINED);
+    logEvent(events, SET_WEIGHT, startId, UNDEFINED, 0);
+
+    int lastVertex;
+    if (DenseGraph::isDense(unchecked.size(), outEdgeCount(graph, unchecked))) {
+        TRACE_SCOPE("Dijkstra::runDense");
+        lastVertex = runDense(graph, startId, unchecked, events);
+    }
+    else {
+        TRACE_SCOPE("Dijkstra::dijkstraAlgorithm");
+        lastVertex = dijkstraAlgorithm(graph, startId, weights, checkedEdges, unchecked, checked, events);
+    }
+
+    logEvent(events, SET_END_VERTEX, lastVertex, UNDEFINED, UNDEFINED);
+
+    return events;
+}
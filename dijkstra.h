@@ -1,44 +1,57 @@
-#ifndef DIJKSTRA_H
-#define DIJKSTRA_H
-
-#include "vertex.h"
-#include "edge.h"
-
-#include <unordered_map>
-#include <vector>
-
-enum EventName {
-    SET_START_VERTEX,
-    SET_CURRENT_VERTEX,
-    SET_END_VERTEX,
-    CHECK_VERTEX,
-    CHECK_EDGE,
-    UNCHECK_VERTEX,
-    UNCHECK_EDGE,
-    SET_WEIGHT
-};
-
-struct Event {
-    EventName name;
-    int vertexId;
-    int edgeId;
-    qreal weight;
-};
-
-typedef std::unordered_map<int, Vertex*> vertexMap;
-typedef std::unordered_map<int, Edge*> edgeMap;
-typedef std::vector<Event> Events;
-
-class Dijkstra {
-
-public:
-    static Events run(Vertex &startVertex, vertexMap vertices, edgeMap edges);
-
-private:
-    static void logEvent(Events &events, EventName name, int vertexId, int edgeId, qreal weight);
-    static void weightsToInf(Vertex& startVertex, vertexMap vertices, std::vector<int>& unchecked, Events &events);
-    static int dijkstraAlgorithm(Vertex &startVertex, vertexMap vertices, edgeMap edges,
-                                 std::vector<int>& checkedEdges, std::vector<int>& unchecked, std::vector<int>& checked, Events &events);
-};
-
-#endif // DIJKSTRA_H
+#ifndef DIJKSTRA_H
+#define DIJKSTRA_H
+
+#include "graphsnapshot.h"
+
+#include <unordered_map>
+#include <vector>
+
+enum EventName {
+    SET_START_VERTEX,
+    SET_CURRENT_VERTEX,
+    SET_END_VERTEX,
+    CHECK_VERTEX,
+    CHECK_EDGE,
+    UNCHECK_VERTEX,
+    UNCHECK_EDGE,
+    SET_WEIGHT
+};
+
+struct Event {
+    EventName name;
+    int vertexId;
+    int edgeId;
+    qreal weight;
+};
+
+typedef std::vector<Event> Events;
+typedef std::unordered_map<int, qreal> weightMap;
+
+class Dijkstra {
+
+public:
+    static Events run(const GraphSnapshot &graph, int startId);
+
+    // Larger reachable subgraphs skip the step-by-step trace
+    static constexpr size_t ANIMATION_LIMIT = 1000;
+
+    // Graphs with more edges run on the compressed adjacency
+    static constexpr size_t COMPRESSION_EDGE_LIMIT = 1 << 24;
+
+private:
+    static void logEvent(Events &events, EventName name, int vertexId, int edgeId, qreal weight);
+    static int dijkstraAlgorithm(const GraphSnapshot &graph, int vertexId, weightMap &weights,
+                                 std::vector<int>& checkedEdges, std::vector<int>& unchecked, std::vector<int>& checked, Events &events);
+    static int runDense(const GraphSnapshot &graph, int startId, const std::vector<int> &vertexIds, Events &events);
+    static int runDenseEngine(const GraphSnapshot &graph, int startId, const std::vector<int> &vertexIds, Events &events);
+    static size_t outEdgeCount(const GraphSnapshot &graph, const std::vector<int> &vertexIds);
+    static int runFlat(const GraphSnapshot &graph, int startId, Events &events);
+
+    template <typename Weight>
+    static int runFlat(const GraphSnapshot &graph, int startId, Events &events);
+
+    template <typename Graph>
+    static int runEngine(const Graph &graph, int startId, Events &events);
+};
+
+#endif // DIJKSTRA_H
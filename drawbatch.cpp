@@ -0,0 +1,158 @@
+#include "drawbatch.h"
+#include "memoryreport.h"
+
+#include <algorithm>
+
+void DrawBatch::clear() {
+    for (size_t i = 0; i < used; ++i) {
+        Bucket& current = buckets[i];
+        current.lines.clear();
+        current.arrows.clear();
+        current.ellipses.clear();
+        current.texts.clear();
+    }
+    used = 0;
+    last = 0;
+}
+
+size_t DrawBatch::memoryUsage() const {
+    size_t bytes = MemoryReport::vectorBytes(buckets);
+    for (const Bucket& bucket : buckets) {
+        bytes += MemoryReport::vectorBytes(bucket.lines) + MemoryReport::vectorBytes(bucket.arrows)
+                 + MemoryReport::vectorBytes(bucket.ellipses) + MemoryReport::vectorBytes(bucket.texts);
+    }
+    return bytes;
+}
+
+DrawBatch::Bucket& DrawBatch::bucket(const Style &style) {
+    // Consecutive items usually share a style
+    if (last < used && buckets[last].style == style) return buckets[last];
+
+    for (size_t i = 0; i < used; ++i) {
+        if (buckets[i].style == style) {
+            last = i;
+            return buckets[i];
+        }
+    }
+
+    if (used == buckets.size()) buckets.emplace_back();
+    buckets[used].style = style;
+    last = used++;
+    return buckets[last];
+}
+
+void DrawBatch::addLine(const Style &style, const QLineF &line) {
+    bucket(style).lines.push_back(line);
+}
+
+void DrawBatch::addArrow(const Style &style, const QPointF &base, const QPointF &firstWing, const QPointF &secondWing) {
+    bucket(style).arrows.push_back({base, firstWing, secondWing});
+}
+
+void DrawBatch::addEllipse(const Style &style, const QPointF &center, qreal radius) {
+    bucket(style).ellipses.push_back({center, radius});
+}
+
+void DrawBatch::addText(const QColor &color, bool isItalic, const QPointF &textPos, const LabelCache::Label &label) {
+    Style style;
+    style.pen = color;
+    style.isItalic = isItalic;
+    bucket(style).texts.push_back({textPos, label});
+}
+
+void DrawBatch::flush(QPainter &painter, const LabelCache &labels) {
+    draw(painter, labels.getFont(false), labels.getFont(true), QRectF(), true);
+    clear();
+}
+
+void DrawBatch::draw(QPainter &painter, const QFont &regularFont, const QFont &italicFont,
+                     const QRectF &clip, bool useStaticText) const {
+    const bool isClipped = !clip.isNull();
+
+    auto applyStyle = [&](const Style &style) {
+        painter.setOpacity(style.opacity);
+        painter.setPen(QPen(style.pen, style.width));
+        painter.setBrush(style.brush);
+    };
+
+    auto isVisible = [&](qreal left, qreal top, qreal right, qreal bottom) {
+        return !isClipped || (right >= clip.left() && left <= clip.right() && bottom >= clip.top() && top <= clip.bottom());
+    };
+
+    std::vector<QLineF> visibleLines;
+    for (size_t i = 0; i < used; ++i) {
+        const Bucket& current = buckets[i];
+        if (current.lines.empty()) continue;
+
+        const std::vector<QLineF>* lines = &current.lines;
+        if (isClipped) {
+            visibleLines.clear();
+            for (const QLineF& line : current.lines) {
+                if (isVisible(std::min(line.x1(), line.x2()), std::min(line.y1(), line.y2()),
+                              std::max(line.x1(), line.x2()), std::max(line.y1(), line.y2()))) {
+                    visibleLines.push_back(line);
+                }
+            }
+            if (visibleLines.empty()) continue;
+            lines = &visibleLines;
+        }
+
+        applyStyle(current.style);
+        painter.drawLines(lines->data(), lines->size());
+    }
+
+    for (size_t i = 0; i < used; ++i) {
+        const Bucket& current = buckets[i];
+        if (current.arrows.empty()) continue;
+
+        QPainterPath path;
+        path.setFillRule(Qt::WindingFill);
+        for (const Arrow& arrow : current.arrows) {
+            if (!isVisible(std::min({arrow.base.x(), arrow.firstWing.x(), arrow.secondWing.x()}),
+                           std::min({arrow.base.y(), arrow.firstWing.y(), arrow.secondWing.y()}),
+                           std::max({arrow.base.x(), arrow.firstWing.x(), arrow.secondWing.x()}),
+                           std::max({arrow.base.y(), arrow.firstWing.y(), arrow.secondWing.y()}))) continue;
+
+            path.moveTo(arrow.base);
+            path.lineTo(arrow.firstWing);
+            path.lineTo(arrow.secondWing);
+        }
+        if (path.isEmpty()) continue;
+
+        applyStyle(current.style);
+        painter.drawPath(path);
+    }
+
+    for (size_t i = 0; i < used; ++i) {
+        const Bucket& current = buckets[i];
+        if (current.ellipses.empty()) continue;
+
+        applyStyle(current.style);
+        for (const Ellipse& ellipse : current.ellipses) {
+            const QPointF& center = ellipse.center;
+            if (!isVisible(center.x() - ellipse.radius, center.y() - ellipse.radius,
+                           center.x() + ellipse.radius, center.y() + ellipse.radius)) continue;
+
+            painter.drawEllipse(center, ellipse.radius, ellipse.radius);
+        }
+    }
+
+    for (size_t i = 0; i < used; ++i) {
+        const Bucket& current = buckets[i];
+        if (current.texts.empty()) continue;
+
+        applyStyle(current.style);
+        painter.setFont(current.style.isItalic ? italicFont : regularFont);
+        for (const Text& text : current.texts) {
+            const LabelCache::Label& label = text.label;
+            qreal width = -2 * label.centerOffset.x();
+            if (!isVisible(text.pos.x(), text.pos.y() - label.ascent,
+                           text.pos.x() + width, text.pos.y() + label.ascent)) continue;
+
+            if (useStaticText) LabelCache::draw(painter, text.pos, label);
+            else painter.drawText(text.pos, label.text.text());
+        }
+    }
+
+    painter.setOpacity(1);
+}
@@ -0,0 +1,79 @@
+#ifndef DRAWBATCH_H
+#define DRAWBATCH_H
+
+#include "labelcache.h"
+
+#include <vector>
+
+#include <QColor>
+#include <QLineF>
+#include <QPainter>
+#include <QPainterPath>
+
+// Primitives collected during a frame and grouped by style, so the painter
+// state changes once per style instead of once per item. Drawing submits all
+// lines, then arrows, then ellipses, then text.
+class DrawBatch {
+
+public:
+    struct Style {
+        QColor pen;
+        QColor brush = Qt::transparent;
+        qreal width = 1;
+        qreal opacity = 1;
+        bool isItalic = false;
+
+        bool operator==(const Style &other) const {
+            return pen == other.pen && brush == other.brush && width == other.width
+                   && opacity == other.opacity && isItalic == other.isItalic;
+        }
+    };
+
+    void clear();
+    void addLine(const Style &style, const QLineF &line);
+    void addArrow(const Style &style, const QPointF &base, const QPointF &firstWing, const QPointF &secondWing);
+    void addEllipse(const Style &style, const QPointF &center, qreal radius);
+    void addText(const QColor &color, bool isItalic, const QPointF &textPos, const LabelCache::Label &label);
+    void flush(QPainter &painter, const LabelCache &labels);
+    size_t memoryUsage() const;
+
+    // Read-only, so several threads can draw one batch into their own images.
+    // Items outside a non-empty clip (in scene coordinates) are skipped, and
+    // text is laid out by the painter instead of through the shared QStaticText.
+    void draw(QPainter &painter, const QFont &regularFont, const QFont &italicFont,
+              const QRectF &clip, bool useStaticText) const;
+
+private:
+    struct Arrow {
+        QPointF base;
+        QPointF firstWing;
+        QPointF secondWing;
+    };
+
+    struct Ellipse {
+        QPointF center;
+        qreal radius;
+    };
+
+    struct Text {
+        QPointF pos;
+        LabelCache::Label label;
+    };
+
+    struct Bucket {
+        Style style;
+        std::vector<QLineF> lines;
+        std::vector<Arrow> arrows;
+        std::vector<Ellipse> ellipses;
+        std::vector<Text> texts;
+    };
+
+    Bucket& bucket(const Style &style);
+
+    // Buckets are kept between frames so their vectors keep their capacity
+    std::vector<Bucket> buckets;
+    size_t used = 0;
+    size_t last = 0;
+};
+
+#endif // DRAWBATCH_H
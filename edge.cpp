@@ -1,137 +1,156 @@
-#include "utils.h"
-#include "edge.h"
-#include "canvas.h"
-
-#include <QPainter>
-#include <QPainterPath>
-#include <QFontMetrics>
-
-Edge::Edge(QString displayText, int edgeId, int fristId, int secodnId, qreal weight, QWidget* parent)
-    : displayText(displayText), id(edgeId), startId(fristId), endId(secodnId), weight(weight) {}
-
-QPointF newVector(const QLineF& direction, const qreal length) {
-    qreal directionLength = direction.length();
-    qreal sin = direction.dy() / directionLength;
-    qreal cos = direction.dx() / directionLength;
-
-    return {length * cos, length * sin};
-}
-
-QPointF newVector(const QLineF& direction, const QPointF shift) {
-    qreal directionLength = direction.length();
-    qreal sin = direction.dy() / directionLength;
-    qreal cos = direction.dx() / directionLength;
-
-    return {shift.x() * cos, shift.y() * sin};
-}
-
-QLineF shiftLine(QLineF line, QLineF direction, qreal shiftValue) {
-    QPointF shift = newVector(direction, shiftValue);
-    return QLineF{line.p1() + shift, line.p2() + shift};
-}
-
-QPointF closestPoint(QLineF line, QLineF normal, QPointF origin) {
-    QPointF intersectionPoint;
-    line.intersects(normal, &intersectionPoint);
-
-    QPointF closestPoint = intersectionPoint;
-
-    qreal distToStart = QLineF{intersectionPoint, line.p1()}.length();
-    qreal distToEnd = QLineF{intersectionPoint, line.p2()}.length();
-    qreal edgeLineLength = line.length();
-
-    if (distToStart > edgeLineLength || distToEnd > edgeLineLength) {
-        if (QLineF{origin, line.p1()}.length() > QLineF{origin, line.p2()}.length()) {
-            return line.p2();
-        }
-        else {
-            return line.p1();
-        }
-    }
-
-    return closestPoint;
-}
-
-QPointF closestPoint(QString text, QPointF textPos, QPointF textCenterOffset, QPointF origin) {
-    QLineF inTextLine{textPos - textCenterOffset, origin};
-    qreal textRadius = qSqrt(QPointF::dotProduct(textCenterOffset, textCenterOffset));
-    if (inTextLine.length() <= textRadius) return origin;
-    inTextLine.setLength(textRadius);
-    return inTextLine.p2();
-}
-
-void Edge::drawArrow(QPainter& painter, QLineF invertedEdgeLine, qreal vertexRadius) {
-    QLineF line = invertedEdgeLine;
-    qreal distToCircle = sqrt(vertexRadius * vertexRadius - EDGE_BOTH_SHIFT * EDGE_BOTH_SHIFT / 4);
-    line.setLength(distToCircle);
-
-    QLineF wing1{line.p2(), invertedEdgeLine.p2()};
-    QLineF wing2{line.p2(), invertedEdgeLine.p2()};
-
-    wing1.setLength(ARROW_LENGTH);
-    wing2.setLength(ARROW_LENGTH);
-
-    wing1.setAngle(line.angle() + ARROW_ANGLE);
-    wing2.setAngle(line.angle() - ARROW_ANGLE);
-
-    painter.setOpacity(1);
-
-    QPainterPath path;
-    path.moveTo(wing1.p1());
-    path.lineTo(wing1.p2());
-    path.lineTo(wing2.p2());
-    painter.drawPath(path);
-}
-
-qreal Edge::distanceToPoint(QFontMetrics fontMetrics, QPointF *textPos,
-                            QLineF edgeLine, QLineF normal,
-                            Vertex* start, Vertex* end,
-                            QPointF point) {
-    QPointF textCenterOffset = utils::getTextCenterAlign(fontMetrics, displayText);
-    QPointF shift = newVector(normal, {EDGE_TEXT_SHIFT - textCenterOffset.x(), EDGE_TEXT_SHIFT + textCenterOffset.y()});
-    *textPos = edgeLine.center() + textCenterOffset + shift;
-
-    return std::min(QLineF{point, closestPoint(edgeLine, normal, point)}.length(),
-                    QLineF{point, closestPoint(displayText, *textPos, textCenterOffset, point)}.length());
-}
-
-void Edge::draw(Canvas *canvas, QPainter& painter, bool isForceBoth) {
-    Vertex* start = canvas->getVertex(startId);
-    Vertex* end = canvas->getVertex(endId);
-    QLineF edgeLine = {start->pos, end->pos};
-    QLineF normal(canvas->getScreenCenter(), {0, 0});
-    normal.setAngle(edgeLine.angle() + 90);
-
-    if (utils::contains(start->in.vertexId, endId) || isForceBoth) {
-        edgeLine = shiftLine(edgeLine, normal, EDGE_BOTH_SHIFT / 2);
-    }
-
-    QPointF textPos;
-    qreal closestDist = distanceToPoint(painter.fontMetrics(), &textPos, edgeLine, normal, start, end, canvas->getScreenCenter());
-
-    if (closestDist - LINE_THICKNESS > canvas->getHalfScreenDiagonal()) return;
-
-    bool isSelected = start->isSelected && end->isSelected || utils::contains(canvas->selectedEdges, id);
-    if (isSelected) {
-        painter.setBrush(Qt::green);
-        painter.setPen(Qt::green);
-    }
-    else if (utils::contains(canvas->djCheckedEdges, id)) {
-        painter.setBrush(dChekcedColor);
-        painter.setPen(dChekcedColor);
-    }
-
-    painter.drawLine(edgeLine);
-    drawArrow(painter, {edgeLine.p2(), edgeLine.p1()}, end->radius);
-
-    if (isSelected) {
-        painter.setPen(Qt::darkGreen);
-    }
-    else {
-        painter.setPen(Qt::black);
-    }
-
-    painter.drawText(textPos, displayText);
-    painter.setBrush(Qt::black);
-    painter.setPen(Qt::black);
-}
+#include "utils.h"
+#include "edge.h"
+#include "canvas.h"
+
+#include <QPainter>
+#include <QPainterPath>
+#include <QFontMetrics>
+
+#include <algorithm>
+
+Edge::Edge(QString displayText, int edgeId, int fristId, int secodnId, qreal weight, QWidget* parent)
+    : displayText(displayText), id(edgeId), startId(fristId), endId(secodnId), weight(weight) {}
+
+QPointF newVector(const QLineF& direction, const qreal length) {
+    qreal directionLength = direction.length();
+    qreal sin = direction.dy() / directionLength;
+    qreal cos = direction.dx() / directionLength;
+
+    return {length * cos, length * sin};
+}
+
+QPointF newVector(const QLineF& direction, const QPointF shift) {
+    qreal directionLength = direction.length();
+    qreal sin = direction.dy() / directionLength;
+    qreal cos = direction.dx() / directionLength;
+
+    return {shift.x() * cos, shift.y() * sin};
+}
+
+QLineF shiftLine(QLineF line, QLineF direction, qreal shiftValue) {
+    QPointF shift = newVector(direction, shiftValue);
+    return QLineF{line.p1() + shift, line.p2() + shift};
+}
+
+QPointF closestPoint(const QLineF& line, const QPointF& origin) {
+    QPointF direction = line.p2() - line.p1();
+    qreal lengthSquared = QPointF::dotProduct(direction, direction);
+    if (lengthSquared == 0) return line.p1();
+
+    qreal t = QPointF::dotProduct(origin - line.p1(), direction) / lengthSquared;
+    return line.p1() + direction * std::clamp<qreal>(t, 0, 1);
+}
+
+void Edge::computeArrow(QLineF invertedEdgeLine, qreal vertexRadius, Geometry& geometry) {
+    QLineF line = invertedEdgeLine;
+    qreal distToCircle = sqrt(vertexRadius * vertexRadius - EDGE_BOTH_SHIFT * EDGE_BOTH_SHIFT / 4);
+    line.setLength(distToCircle);
+
+    QLineF wing1{line.p2(), invertedEdgeLine.p2()};
+    QLineF wing2{line.p2(), invertedEdgeLine.p2()};
+
+    wing1.setLength(ARROW_LENGTH);
+    wing2.setLength(ARROW_LENGTH);
+
+    wing1.setAngle(line.angle() + ARROW_ANGLE);
+    wing2.setAngle(line.angle() - ARROW_ANGLE);
+
+    geometry.arrowBase = wing1.p1();
+    geometry.firstWing = wing1.p2();
+    geometry.secondWing = wing2.p2();
+}
+
+void Edge::computeGeometry(Canvas *canvas, bool isForceBoth, Geometry& geometry) {
+    Vertex* end = canvas->getVertex(endId);
+    QLineF edgeLine = {canvas->getVertex(startId)->pos, end->pos};
+    QLineF normal({0, 0}, {1, 0});
+    normal.setAngle(edgeLine.angle() + 90);
+
+    geometry.isShifted = canvas->hasEdge(endId, startId) || isForceBoth;
+    if (geometry.isShifted) {
+        edgeLine = shiftLine(edgeLine, normal, EDGE_BOTH_SHIFT / 2);
+    }
+    geometry.line = edgeLine;
+
+    const LabelCache::Label& label = canvas->labels.get(displayText);
+    QPointF shift = newVector(normal, {EDGE_TEXT_SHIFT - label.centerOffset.x(), EDGE_TEXT_SHIFT + label.centerOffset.y()});
+    geometry.textPos = edgeLine.center() + label.centerOffset + shift;
+    geometry.textCenter = geometry.textPos - label.centerOffset;
+    geometry.textRadius = qSqrt(QPointF::dotProduct(label.centerOffset, label.centerOffset));
+    geometry.textRect = QRectF(geometry.textPos.x(), geometry.textPos.y() - label.ascent, -2 * label.centerOffset.x(), 2 * label.ascent);
+
+    computeArrow({edgeLine.p2(), edgeLine.p1()}, end->radius, geometry);
+
+    // Margin covers the arrow, the line width and the shift of a two-way pair
+    const qreal margin = LINE_THICKNESS + ARROW_LENGTH + EDGE_BOTH_SHIFT;
+    QRectF lineRect = QRectF(edgeLine.p1(), edgeLine.p2()).normalized();
+    geometry.bounds = lineRect.united(geometry.textRect).adjusted(-margin, -margin, margin, margin);
+}
+
+const Edge::Geometry& Edge::getGeometry(Canvas *canvas) {
+    if (!isGeometryValid) {
+        computeGeometry(canvas, false, geometry);
+        isGeometryValid = id >= 0;
+    }
+    return geometry;
+}
+
+// Distance to the segment or to the circle around the label
+qreal Edge::distanceToPoint(const Geometry& geometry, const QPointF& point) {
+    qreal lineDistance = QLineF{point, closestPoint(geometry.line, point)}.length();
+    qreal textDistance = std::max<qreal>(0, QLineF{point, geometry.textCenter}.length() - geometry.textRadius);
+    return std::min(lineDistance, textDistance);
+}
+
+qreal Edge::distanceToPoint(Canvas *canvas, const QPointF &point) {
+    return distanceToPoint(getGeometry(canvas), point);
+}
+
+QRectF Edge::bounds(Canvas *canvas) {
+    return getGeometry(canvas).bounds;
+}
+
+void Edge::draw(Canvas *canvas, DrawBatch& batch, bool isForceBoth, qreal opacity) {
+    Vertex* start = canvas->getVertex(startId);
+    Vertex* end = canvas->getVertex(endId);
+
+    // A lone edge moves aside while a weight is typed in the other direction
+    const Geometry* current = &getGeometry(canvas);
+    Geometry forced;
+    if (isForceBoth && !current->isShifted) {
+        computeGeometry(canvas, true, forced);
+        current = &forced;
+    }
+
+    qreal closestDist = distanceToPoint(*current, canvas->getScreenCenter());
+    bool isCulled = closestDist - LINE_THICKNESS > canvas->getHalfScreenDiagonal();
+    if (!isCulled && canvas->isPartialPaint) {
+        isCulled = !canvas->paintBounds.intersects(current->bounds);
+    }
+
+    if (isCulled) {
+        canvas->profiler.countEdge(false);
+        return;
+    }
+    canvas->profiler.countEdge(true);
+
+    bool isSelected = start->isSelected && end->isSelected || utils::contains(canvas->selectedEdges, id);
+    DrawBatch::Style style = {Qt::black, Qt::black};
+    QColor textColor = Qt::black;
+    if (isSelected) {
+        style = {Qt::green, Qt::green};
+        textColor = Qt::darkGreen;
+    }
+    else if (canvas->djCheckedEdges.count(id)) {
+        style = {dChekcedColor, dChekcedColor};
+    }
+
+    DrawBatch::Style lineStyle = style;
+    lineStyle.opacity = opacity;
+
+    batch.addLine(lineStyle, current->line);
+    batch.addArrow(style, current->arrowBase, current->firstWing, current->secondWing);
+
+    batch.addText(textColor, false, current->textPos, canvas->labels.get(displayText));
+    canvas->profiler.countText();
+}
@@ -1,37 +1,63 @@
-#ifndef EDGE_H
-#define EDGE_H
-
-#include <QWidget>
-
-class Vertex;
-class Canvas;
-
-class Edge {
-
-public:
-    Edge(QString displayText, int edgeId, int fristId, int secodnId, qreal weight, QWidget* parent = nullptr);
-
-    qreal distanceToPoint(QFontMetrics fontMetrics, QPointF *textPos,
-                          QLineF edgeLine, QLineF normal,
-                          Vertex* start, Vertex* end,
-                          QPointF point);
-    void draw(Canvas *canvas, QPainter& painter, bool isForceBoth);
-
-    QString displayText;
-    int id;
-    int startId;
-    int endId;
-    qreal weight;
-
-private:
-    void drawArrow(QPainter& painter, QLineF invertedEdgeLine, qreal vertexRadius);
-
-    const qreal EDGE_TEXT_SHIFT = 15;
-    const qreal EDGE_BOTH_SHIFT = 12;
-    const qreal ARROW_LENGTH = 13;
-    const qreal ARROW_ANGLE = 13;
-    const qreal LINE_THICKNESS = 5;
-    const QColor dChekcedColor = QColor(255, 180, 162);
-};
-
-#endif // EDGE_H
+#ifndef EDGE_H
+#define EDGE_H
+
+#include "drawbatch.h"
+
+#include <QWidget>
+
+class Vertex;
+class Canvas;
+
+class Edge {
+
+public:
+    Edge(QString displayText, int edgeId, int fristId, int secodnId, qreal weight, QWidget* parent = nullptr);
+
+    qreal distanceToPoint(Canvas *canvas, const QPointF &point);
+    void draw(Canvas *canvas, DrawBatch& batch, bool isForceBoth, qreal opacity = 1);
+    QRectF bounds(Canvas *canvas);
+
+    // Called when an endpoint moves or the reverse edge comes or goes
+    void invalidateGeometry() { isGeometryValid = false; }
+
+    QString displayText;
+    int id;
+    int startId;
+    int endId;
+    qreal weight;
+    size_t outSlot = 0;
+    size_t inSlot = 0;
+
+private:
+    // Everything drawing and picking need, in scene coordinates
+    struct Geometry {
+        QLineF line;
+        bool isShifted;
+        QPointF textPos;
+        QPointF textCenter;
+        qreal textRadius;
+        QRectF textRect;
+        QPointF arrowBase;
+        QPointF firstWing;
+        QPointF secondWing;
+        QRectF bounds;
+    };
+
+    const Geometry& getGeometry(Canvas *canvas);
+    void computeGeometry(Canvas *canvas, bool isForceBoth, Geometry& geometry);
+    void computeArrow(QLineF invertedEdgeLine, qreal vertexRadius, Geometry& geometry);
+    static qreal distanceToPoint(const Geometry& geometry, const QPointF& point);
+
+    const qreal EDGE_TEXT_SHIFT = 15;
+    const qreal EDGE_BOTH_SHIFT = 12;
+    const qreal ARROW_LENGTH = 13;
+    const qreal ARROW_ANGLE = 13;
+    const qreal LINE_THICKNESS = 5;
+    const QColor dChekcedColor = QColor(255, 180, 162);
+
+    // The link preview edge (id -1) changes every frame and is never cached
+    Geometry geometry;
+    bool isGeometryValid = false;
+};
+
+#endif // EDGE_H
@@ -0,0 +1,158 @@
+#ifndef FLATGRAPH_H
+#define FLATGRAPH_H
+
+#include "graphsnapshot.h"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Weight types the shortest-path engines are instantiated for. Unreachable
+// vertices hold infinity() rather than the negative sentinels of the canvas.
+template <typename Weight>
+struct WeightTraits;
+
+template <>
+struct WeightTraits<uint32_t> {
+    static constexpr bool IS_INTEGER = true;
+    static constexpr uint32_t infinity() { return std::numeric_limits<uint32_t>::max(); }
+    static bool canRepresent(qreal weight) { return weight >= 0 && weight < infinity() && weight == std::floor(weight); }
+};
+
+template <>
+struct WeightTraits<float> {
+    static constexpr bool IS_INTEGER = false;
+    static constexpr int MANTISSA_BITS = std::numeric_limits<float>::digits;
+    static constexpr float infinity() { return std::numeric_limits<float>::infinity(); }
+    static bool canRepresent(qreal weight) { return qreal(float(weight)) == weight; }
+};
+
+template <>
+struct WeightTraits<double> {
+    static constexpr bool IS_INTEGER = false;
+    static constexpr int MANTISSA_BITS = std::numeric_limits<double>::digits;
+    static constexpr double infinity() { return std::numeric_limits<double>::infinity(); }
+    static bool canRepresent(qreal) { return true; }
+};
+
+// Compressed sparse rows of a snapshot with vertices numbered 0..size()-1,
+// in snapshot order or in the given order of ids (see VertexOrder). Built
+// once per run, so traversals touch contiguous arrays instead of the
+// per-vertex vectors and hash lookups of the snapshot. A reversed graph
+// walks the in-edges, keeping their ids and weights.
+template <typename WeightType>
+class FlatGraph {
+
+public:
+    typedef WeightType Weight;
+    typedef WeightTraits<Weight> Traits;
+
+    FlatGraph(const GraphSnapshot &graph, const std::vector<int> &order = {}, bool isReversed = false) {
+        ids.reserve(graph.vertexCount());
+        index.assign(graph.vertexIdBound(), -1);
+        if (order.empty()) {
+            graph.forEachVertex([&](const VertexRecord &vertex) {
+                ids.push_back(vertex.id);
+            });
+        }
+        else {
+            ids = order;
+        }
+
+        for (size_t i = 0; i < ids.size(); ++i) {
+            index[ids[i]] = i;
+        }
+
+        offsets.assign(ids.size() + 1, 0);
+        for (size_t i = 0; i < ids.size(); ++i) {
+            const VertexRecord *vertex = graph.vertex(ids[i]);
+            offsets[i + 1] = offsets[i] + (isReversed ? vertex->in.edgeId : vertex->out.edgeId).size();
+        }
+
+        targets.resize(offsets.back());
+        weights.resize(offsets.back());
+        edgeIds.resize(offsets.back());
+        maxWeight = 0;
+
+        for (size_t i = 0; i < ids.size(); ++i) {
+            const VertexRecord *vertex = graph.vertex(ids[i]);
+            const std::vector<int> &edgeList = isReversed ? vertex->in.edgeId : vertex->out.edgeId;
+            size_t slot = offsets[i];
+            for (size_t j = 0; j < edgeList.size(); ++j, ++slot) {
+                const EdgeRecord *edge = graph.edge(edgeList[j]);
+                targets[slot] = index[isReversed ? edge->startId : edge->endId];
+                weights[slot] = Weight(edge->weight);
+                edgeIds[slot] = edge->id;
+                maxWeight = std::max(maxWeight, weights[slot]);
+            }
+        }
+    }
+
+    // Whether every weight, and every path sum, fits the weight type exactly.
+    // Sums of floating weights are multiples of the smallest weight step, so
+    // the mantissa has to span from that step up to the longest path
+    static bool canRepresent(const GraphSnapshot &graph) {
+        bool isExact = true;
+        qreal heaviest = 0;
+        int lowestBit = std::numeric_limits<int>::max();
+        graph.forEachEdge([&](const EdgeRecord &edge) {
+            isExact = isExact && Traits::canRepresent(edge.weight);
+            heaviest = std::max(heaviest, edge.weight);
+            if (edge.weight > 0) lowestBit = std::min(lowestBit, lowestBitExponent(edge.weight));
+        });
+        if (!isExact) return false;
+
+        qreal longest = heaviest * graph.vertexCount();
+        if constexpr (Traits::IS_INTEGER) {
+            return Traits::canRepresent(longest);
+        }
+        else {
+            return longest == 0 || longest < std::ldexp(1.0, Traits::MANTISSA_BITS + lowestBit);
+        }
+    }
+
+    int size() const { return ids.size(); }
+    size_t edgeCount() const { return targets.size(); }
+    int indexOf(int id) const { return id >= 0 && size_t(id) < index.size() ? index[id] : -1; }
+    int idAt(int vertex) const { return ids[vertex]; }
+    size_t degree(int vertex) const { return offsets[vertex + 1] - offsets[vertex]; }
+    Weight getMaxWeight() const { return maxWeight; }
+
+    size_t memoryUsage() const {
+        return ids.capacity() * sizeof(int) + index.capacity() * sizeof(int) + offsets.capacity() * sizeof(size_t)
+             + targets.capacity() * sizeof(int) + weights.capacity() * sizeof(Weight) + edgeIds.capacity() * sizeof(int);
+    }
+
+    // Calls function(target, weight, edgeId) for every outgoing edge
+    template <typename Function>
+    void forEachOut(int vertex, const Function& function) const {
+        for (size_t i = offsets[vertex]; i < offsets[vertex + 1]; ++i) {
+            function(targets[i], weights[i], edgeIds[i]);
+        }
+    }
+
+private:
+    // e of the lowest set bit, so that value is an odd multiple of 2^e
+    static int lowestBitExponent(qreal value) {
+        int exponent;
+        qreal fraction = std::frexp(value, &exponent);
+        uint64_t bits = uint64_t(std::ldexp(fraction, std::numeric_limits<qreal>::digits));
+        exponent -= std::numeric_limits<qreal>::digits;
+        while (!(bits & 1)) {
+            bits >>= 1;
+            ++exponent;
+        }
+        return exponent;
+    }
+
+    std::vector<int> ids;
+    std::vector<int> index;
+    std::vector<size_t> offsets;
+    std::vector<int> targets;
+    std::vector<Weight> weights;
+    std::vector<int> edgeIds;
+    Weight maxWeight;
+};
+
+#endif // FLATGRAPH_H
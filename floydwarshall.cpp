@@ -0,0 +1,124 @@
+#include "utils.h"
+#include "floydwarshall.h"
+#include "memoryreport.h"
+#include "parallel.h"
+#include "trace.h"
+
+#include <limits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FLOYD_SSE2
+#endif
+
+static const qreal INF_WEIGHT = std::numeric_limits<qreal>::infinity();
+
+qreal DistanceMatrix::distance(int fromId, int toId) const {
+    qreal value = distances[size_t(index.at(fromId)) * stride + index.at(toId)];
+    return value == INF_WEIGHT ? INF : value;
+}
+
+size_t DistanceMatrix::memoryUsage() const {
+    return MemoryReport::vectorBytes(ids) + MemoryReport::hashBytes(index) + MemoryReport::vectorBytes(distances);
+}
+
+void DistanceMatrix::clear() {
+    stride = 0;
+    ids.clear();
+    index.clear();
+    distances.clear();
+}
+
+// target[i][j] = min(target[i][j], left[i][k] + top[k][j]) for one tile.
+// k is the outer loop, so the in-place phases (where target aliases left or
+// top) still follow the classic Floyd-Warshall order.
+void FloydWarshall::relaxTile(qreal *target, const qreal *left, const qreal *top, int stride) {
+    for (int k = 0; k < TILE; ++k) {
+        const qreal *topRow = top + size_t(k) * stride;
+
+        for (int i = 0; i < TILE; ++i) {
+            qreal *targetRow = target + size_t(i) * stride;
+            qreal viaK = left[size_t(i) * stride + k];
+            if (viaK == INF_WEIGHT) continue;
+
+#if defined(__AVX2__)
+            __m256d base = _mm256_set1_pd(viaK);
+            for (int j = 0; j < TILE; j += 4) {
+                __m256d candidate = _mm256_add_pd(base, _mm256_loadu_pd(topRow + j));
+                _mm256_storeu_pd(targetRow + j, _mm256_min_pd(candidate, _mm256_loadu_pd(targetRow + j)));
+            }
+#elif defined(FLOYD_SSE2)
+            __m128d base = _mm_set1_pd(viaK);
+            for (int j = 0; j < TILE; j += 2) {
+                __m128d candidate = _mm_add_pd(base, _mm_loadu_pd(topRow + j));
+                _mm_storeu_pd(targetRow + j, _mm_min_pd(candidate, _mm_loadu_pd(targetRow + j)));
+            }
+#else
+            for (int j = 0; j < TILE; ++j) {
+                qreal candidate = viaK + topRow[j];
+                if (candidate < targetRow[j]) targetRow[j] = candidate;
+            }
+#endif
+        }
+    }
+}
+
+DistanceMatrix FloydWarshall::run(const GraphSnapshot &graph) {
+    TRACE_SCOPE("FloydWarshall::run");
+    DistanceMatrix result;
+    const int count = graph.vertexCount();
+    const int stride = (count + TILE - 1) / TILE * TILE;
+    const int tiles = stride / TILE;
+
+    result.stride = stride;
+    result.ids.reserve(count);
+    graph.forEachVertex([&](const VertexRecord &vertex) {
+        result.index.insert({vertex.id, result.ids.size()});
+        result.ids.push_back(vertex.id);
+    });
+
+    std::vector<qreal>& dist = result.distances;
+    dist.assign(size_t(stride) * stride, INF_WEIGHT);
+    for (int i = 0; i < count; ++i) {
+        dist[size_t(i) * stride + i] = 0;
+    }
+    graph.forEachEdge([&](const EdgeRecord &edge) {
+        qreal& cell = dist[size_t(result.index.at(edge.startId)) * stride + result.index.at(edge.endId)];
+        cell = std::min(cell, edge.weight);
+    });
+
+    auto tile = [&](int row, int column) {
+        return dist.data() + size_t(row) * TILE * stride + size_t(column) * TILE;
+    };
+
+    for (int k = 0; k < tiles; ++k) {
+        // Diagonal tile depends only on itself
+        relaxTile(tile(k, k), tile(k, k), tile(k, k), stride);
+
+        // Tiles in row k and column k depend on the diagonal tile
+        parallel::forEach(2 * size_t(tiles), [&](size_t task) {
+            int other = task / 2;
+            if (other == k) return;
+
+            if (task % 2 == 0) {
+                relaxTile(tile(k, other), tile(k, k), tile(k, other), stride);
+            }
+            else {
+                relaxTile(tile(other, k), tile(other, k), tile(k, k), stride);
+            }
+        });
+
+        // Remaining tiles depend on row k and column k only
+        parallel::forEach(size_t(tiles) * tiles, [&](size_t task) {
+            int row = task / tiles;
+            int column = task % tiles;
+            if (row == k || column == k) return;
+
+            relaxTile(tile(row, column), tile(row, k), tile(k, column), stride);
+        });
+    }
+
+    return result;
+}
@@ -0,0 +1,41 @@
+#ifndef FLOYDWARSHALL_H
+#define FLOYDWARSHALL_H
+
+#include "graphsnapshot.h"
+
+#include <unordered_map>
+#include <vector>
+
+class DistanceMatrix {
+
+public:
+    bool isEmpty() const { return ids.empty(); }
+    bool contains(int vertexId) const { return index.find(vertexId) != index.end(); }
+    const std::vector<int>& getIds() const { return ids; }
+    qreal distance(int fromId, int toId) const;
+    size_t memoryUsage() const;
+    void clear();
+
+private:
+    friend class FloydWarshall;
+
+    int stride = 0;
+    std::vector<int> ids;
+    std::unordered_map<int, int> index;
+    std::vector<qreal> distances;
+};
+
+class FloydWarshall {
+
+public:
+    static DistanceMatrix run(const GraphSnapshot &graph);
+
+    // The matrix grows with V² and the run with V³, so larger graphs are refused
+    static constexpr size_t MAX_VERTICES = 4096;
+    static constexpr int TILE = 64;
+
+private:
+    static void relaxTile(qreal *target, const qreal *left, const qreal *top, int stride);
+};
+
+#endif // FLOYDWARSHALL_H
@@ -0,0 +1,216 @@
+#include "forcelayout.h"
+#include "parallel.h"
+#include "trace.h"
+
+#include <cmath>
+
+ForceLayout::~ForceLayout() {
+    stop();
+}
+
+void ForceLayout::start(const GraphSnapshot &graph) {
+    stop();
+
+    ids.clear();
+    positions.clear();
+    std::unordered_map<int, int> index;
+    graph.forEachVertex([&](const VertexRecord &vertex) {
+        index.insert({vertex.id, ids.size()});
+        ids.push_back(vertex.id);
+        positions.push_back(vertex.pos);
+    });
+
+    // Undirected neighbour lists so every vertex sums its own spring forces
+    std::vector<int> degree(ids.size() + 1, 0);
+    graph.forEachEdge([&](const EdgeRecord &edge) {
+        ++degree[index.at(edge.startId)];
+        ++degree[index.at(edge.endId)];
+    });
+
+    neighbourStart.assign(ids.size() + 1, 0);
+    for (size_t i = 0; i < ids.size(); ++i) {
+        neighbourStart[i + 1] = neighbourStart[i] + degree[i];
+    }
+
+    neighbours.resize(neighbourStart.back());
+    std::vector<int> fill(neighbourStart.begin(), neighbourStart.end() - 1);
+    graph.forEachEdge([&](const EdgeRecord &edge) {
+        int start = index.at(edge.startId);
+        int end = index.at(edge.endId);
+        neighbours[fill[start]++] = end;
+        neighbours[fill[end]++] = start;
+    });
+
+    displacements.assign(ids.size(), {0, 0});
+    hasPublished = false;
+    stopRequested = false;
+    running = true;
+    worker = std::thread(&ForceLayout::run, this);
+}
+
+void ForceLayout::stop() {
+    stopRequested = true;
+    if (worker.joinable()) worker.join();
+    running = false;
+}
+
+bool ForceLayout::takePositions(std::vector<int>& vertexIds, std::vector<QPointF>& newPositions) {
+    std::lock_guard<std::mutex> lock(publishMutex);
+    if (!hasPublished) return false;
+
+    vertexIds = ids;
+    newPositions.swap(published);
+    hasPublished = false;
+    return true;
+}
+
+int ForceLayout::childFor(int node, const QPointF& pos) {
+    const QPointF& center = tree[node].center;
+    return (pos.x() >= center.x() ? 1 : 0) + (pos.y() >= center.y() ? 2 : 0);
+}
+
+void ForceLayout::insert(int body) {
+    const QPointF& pos = positions[body];
+    int node = 0;
+
+    while (true) {
+        QuadNode& current = tree[node];
+        current.massCenter = (current.massCenter * current.mass + pos) / (current.mass + 1);
+        ++current.mass;
+
+        if (current.mass == 1) {
+            current.body = body;
+            return;
+        }
+
+        // Coincident bodies stay together in one leaf instead of splitting forever
+        if (current.halfSize < 1e-3) {
+            current.body = -1;
+            return;
+        }
+
+        if (current.body >= 0) {
+            int previous = current.body;
+            tree[node].body = -1;
+
+            for (int i = 0; i < 4; ++i) {
+                QuadNode child;
+                qreal quarter = tree[node].halfSize / 2;
+                child.center = tree[node].center + QPointF{i & 1 ? quarter : -quarter, i & 2 ? quarter : -quarter};
+                child.halfSize = quarter;
+                tree[node].children[i] = tree.size();
+                tree.push_back(child);
+            }
+
+            QuadNode& moved = tree[tree[node].children[childFor(node, positions[previous])]];
+            moved.massCenter = positions[previous];
+            moved.mass = 1;
+            moved.body = previous;
+        }
+        else if (tree[node].children[0] == -1) {
+            return;
+        }
+
+        node = tree[node].children[childFor(node, pos)];
+    }
+}
+
+void ForceLayout::buildTree() {
+    QPointF min = positions[0];
+    QPointF max = positions[0];
+    for (const QPointF& pos : positions) {
+        min = {std::min(min.x(), pos.x()), std::min(min.y(), pos.y())};
+        max = {std::max(max.x(), pos.x()), std::max(max.y(), pos.y())};
+    }
+
+    QuadNode root;
+    root.center = (min + max) / 2;
+    root.halfSize = std::max(max.x() - min.x(), max.y() - min.y()) / 2 + 1;
+
+    tree.clear();
+    tree.reserve(positions.size() * 2);
+    tree.push_back(root);
+
+    for (size_t i = 0; i < positions.size(); ++i) {
+        insert(i);
+    }
+}
+
+// stack is scratch space reused across the bodies of one chunk
+QPointF ForceLayout::repulsion(int body, std::vector<int>& stack) const {
+    const QPointF& pos = positions[body];
+    QPointF force = {0, 0};
+
+    stack.clear();
+    stack.push_back(0);
+
+    while (!stack.empty()) {
+        const QuadNode& node = tree[stack.back()];
+        stack.pop_back();
+        if (node.mass == 0 || node.body == body) continue;
+
+        QPointF delta = pos - node.massCenter;
+        qreal distSquared = QPointF::dotProduct(delta, delta);
+        qreal width = node.halfSize * 2;
+        bool isLeaf = node.children[0] == -1;
+
+        if (isLeaf || width * width < THETA * THETA * distSquared) {
+            if (distSquared < 1e-6) {
+                // Push apart coincident vertices deterministically
+                delta = {qreal(body % 7) - 3, qreal(body % 5) - 2};
+                distSquared = QPointF::dotProduct(delta, delta) + 1;
+            }
+            force += delta * (REPULSION * node.mass / distSquared);
+            continue;
+        }
+
+        for (int child : node.children) {
+            stack.push_back(child);
+        }
+    }
+
+    return force;
+}
+
+void ForceLayout::run() {
+    qreal temperature = START_TEMPERATURE;
+    size_t count = positions.size();
+
+    while (!stopRequested && temperature > MIN_TEMPERATURE && count > 0) {
+        TRACE_SCOPE("ForceLayout::iteration");
+        buildTree();
+        QPointF centroid = tree[0].massCenter;
+
+        size_t chunks = (count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        parallel::forEach(chunks, [&](size_t chunk) {
+            size_t end = std::min(count, (chunk + 1) * CHUNK_SIZE);
+            std::vector<int> stack;
+            for (size_t i = chunk * CHUNK_SIZE; i < end; ++i) {
+                QPointF force = repulsion(i, stack);
+
+                for (int j = neighbourStart[i]; j < neighbourStart[i + 1]; ++j) {
+                    QPointF delta = positions[neighbours[j]] - positions[i];
+                    qreal length = std::sqrt(QPointF::dotProduct(delta, delta));
+                    if (length < 1e-6) continue;
+                    force += delta * (SPRING_STIFFNESS * (length - SPRING_LENGTH) / length);
+                }
+
+                force += (centroid - positions[i]) * GRAVITY;
+
+                qreal length = std::sqrt(QPointF::dotProduct(force, force));
+                displacements[i] = length > temperature ? force * (temperature / length) : force;
+            }
+        });
+
+        for (size_t i = 0; i < count; ++i) {
+            positions[i] += displacements[i];
+        }
+        temperature *= COOLING;
+
+        std::lock_guard<std::mutex> lock(publishMutex);
+        published = positions;
+        hasPublished = true;
+    }
+
+    running = false;
+}
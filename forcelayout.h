@@ -0,0 +1,66 @@
+#ifndef FORCELAYOUT_H
+#define FORCELAYOUT_H
+
+#include "graphsnapshot.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Force-directed layout on a worker thread. Repulsion is approximated with a
+// Barnes-Hut quadtree, springs pull along edges in both directions.
+class ForceLayout {
+
+public:
+    ~ForceLayout();
+
+    void start(const GraphSnapshot &graph);
+    void stop();
+    bool isRunning() const { return running; }
+    bool takePositions(std::vector<int>& vertexIds, std::vector<QPointF>& positions);
+
+    const qreal SPRING_LENGTH = 150;
+    const qreal SPRING_STIFFNESS = 0.05;
+    const qreal REPULSION = 150 * 150;
+    const qreal GRAVITY = 0.01;
+    const qreal THETA = 0.8;
+    const qreal START_TEMPERATURE = 60;
+    const qreal MIN_TEMPERATURE = 0.5;
+    const qreal COOLING = 0.99;
+    const int CHUNK_SIZE = 1024;
+
+private:
+    struct QuadNode {
+        QPointF center;
+        qreal halfSize;
+        QPointF massCenter;
+        int mass = 0;
+        int body = -1;
+        int children[4] = {-1, -1, -1, -1};
+    };
+
+    void run();
+    void buildTree();
+    void insert(int body);
+    int childFor(int node, const QPointF& pos);
+    QPointF repulsion(int body, std::vector<int>& stack) const;
+
+    std::vector<int> ids;
+    std::vector<QPointF> positions;
+    std::vector<QPointF> displacements;
+    std::vector<int> neighbourStart;
+    std::vector<int> neighbours;
+    std::vector<QuadNode> tree;
+
+    std::thread worker;
+    std::atomic<bool> running{false};
+    std::atomic<bool> stopRequested{false};
+
+    std::mutex publishMutex;
+    std::vector<QPointF> published;
+    bool hasPublished = false;
+};
+
+#endif // FORCELAYOUT_H
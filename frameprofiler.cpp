@@ -0,0 +1,108 @@
+#include "frameprofiler.h"
+
+#include <algorithm>
+#include <vector>
+
+void FrameProfiler::setEnabled(bool value) {
+    enabled = value;
+    current = FrameStats();
+    last = FrameStats();
+    historyIndex = 0;
+    historyCount = 0;
+}
+
+void FrameProfiler::beginFrame() {
+    if (!enabled) return;
+
+    current = FrameStats();
+    frameTimer.start();
+}
+
+void FrameProfiler::endFrame() {
+    if (!enabled) return;
+
+    current.frameNs = frameTimer.nsecsElapsed();
+    last = current;
+
+    history[historyIndex] = current.frameNs;
+    historyIndex = (historyIndex + 1) % HISTORY_SIZE;
+    historyCount = std::min(historyCount + 1, HISTORY_SIZE);
+}
+
+void FrameProfiler::beginSection() {
+    if (!enabled) return;
+
+    sectionTimer.start();
+}
+
+void FrameProfiler::endSection(Section section) {
+    if (!enabled) return;
+
+    current.sectionNs[section] += sectionTimer.nsecsElapsed();
+}
+
+qreal FrameProfiler::percentile(qreal fraction) const {
+    if (historyCount == 0) return 0;
+
+    std::vector<qint64> sorted(history.begin(), history.begin() + historyCount);
+    size_t rank = std::min<size_t>(sorted.size() - 1, fraction * sorted.size());
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+    return sorted[rank] / 1e6;
+}
+
+void FrameProfiler::draw(QPainter& painter, int x, int y) {
+    if (!enabled) return;
+
+    const int lineHeight = 18;
+    const int textPaddingX = 6;
+    const int rectOffsetY = 14;
+    const int histogramHeight = 60;
+    const int barWidth = 8;
+
+    auto ms = [](qint64 ns) { return QString::number(ns / 1e6, 'f', 2) + " ms"; };
+
+    QStringList lines = {
+        "Frame: " + ms(last.frameNs) + "  p50 " + QString::number(percentile(0.5), 'f', 2) +
+            " ms  p99 " + QString::number(percentile(0.99), 'f', 2) + " ms",
+        "Grid: " + ms(last.sectionNs[GRID]),
+        "Edges: " + ms(last.sectionNs[EDGES]),
+        "Fake edges: " + ms(last.sectionNs[FAKE_EDGES]),
+        "Vertices: " + ms(last.sectionNs[VERTICES]),
+        "Tiles: " + ms(last.sectionNs[TILES]),
+        "Edges drawn/culled: " + QString::number(last.drawnEdges) + " / " + QString::number(last.culledEdges),
+        "Vertices drawn/culled: " + QString::number(last.drawnVertices) + " / " + QString::number(last.culledVertices),
+        "Text draws: " + QString::number(last.textDraws)
+    };
+
+    painter.save();
+    painter.resetTransform();
+    painter.setOpacity(1);
+    painter.setPen(Qt::black);
+
+    for (const QString& line : lines) {
+        y += lineHeight;
+
+        int textWidth = painter.fontMetrics().horizontalAdvance(line);
+        painter.fillRect(QRect(x - textPaddingX / 2, y - rectOffsetY, textWidth + textPaddingX, lineHeight), Qt::white);
+        painter.drawText(x, y, line);
+    }
+
+    // Frame-time histogram over the last HISTORY_SIZE frames, BUCKET_MS per bar
+    std::array<int, HISTOGRAM_BUCKETS> buckets = {};
+    int highest = 1;
+    for (int i = 0; i < historyCount; ++i) {
+        int bucket = std::min<int>(HISTOGRAM_BUCKETS - 1, history[i] / 1e6 / BUCKET_MS);
+        highest = std::max(highest, ++buckets[bucket]);
+    }
+
+    y += lineHeight / 2;
+    painter.fillRect(QRect(x, y, HISTOGRAM_BUCKETS * barWidth, histogramHeight), Qt::white);
+    painter.setBrush(Qt::gray);
+    painter.setPen(Qt::NoPen);
+    for (int i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+        int height = buckets[i] * histogramHeight / highest;
+        painter.drawRect(QRectF(x + i * barWidth, y + histogramHeight - height, barWidth - 1, height));
+    }
+
+    painter.restore();
+}
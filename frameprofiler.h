@@ -0,0 +1,65 @@
+#ifndef FRAMEPROFILER_H
+#define FRAMEPROFILER_H
+
+#include <array>
+
+#include <QElapsedTimer>
+#include <QPainter>
+
+// Per-frame paint timings and item counts for the canvas overlay. Every
+// hook returns after a single flag test while the profiler is disabled.
+class FrameProfiler {
+
+public:
+    enum Section {
+        GRID,
+        EDGES,
+        FAKE_EDGES,
+        VERTICES,
+        TILES,
+        SECTION_COUNT
+    };
+
+    bool isEnabled() const { return enabled; }
+    void setEnabled(bool value);
+
+    void beginFrame();
+    void endFrame();
+    void beginSection();
+    void endSection(Section section);
+
+    void countVertex(bool isDrawn) { if (enabled) ++(isDrawn ? current.drawnVertices : current.culledVertices); }
+    void countEdge(bool isDrawn) { if (enabled) ++(isDrawn ? current.drawnEdges : current.culledEdges); }
+    void countText() { if (enabled) ++current.textDraws; }
+
+    void draw(QPainter& painter, int x, int y);
+
+private:
+    struct FrameStats {
+        std::array<qint64, SECTION_COUNT> sectionNs = {};
+        qint64 frameNs = 0;
+        int drawnVertices = 0;
+        int culledVertices = 0;
+        int drawnEdges = 0;
+        int culledEdges = 0;
+        int textDraws = 0;
+    };
+
+    qreal percentile(qreal fraction) const;
+
+    static constexpr int HISTORY_SIZE = 240;
+    static constexpr int HISTOGRAM_BUCKETS = 20;
+    static constexpr qreal BUCKET_MS = 2;
+
+    bool enabled = false;
+    QElapsedTimer frameTimer;
+    QElapsedTimer sectionTimer;
+    FrameStats current;
+    FrameStats last;
+
+    std::array<qint64, HISTORY_SIZE> history = {};
+    int historyIndex = 0;
+    int historyCount = 0;
+};
+
+#endif // FRAMEPROFILER_H
@@ -0,0 +1,357 @@
+#include "graphgenerator.h"
+#include "parallel.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <QLineF>
+#include <QStringList>
+
+// Random streams per purpose, so positions don't depend on the edge count
+enum Purpose {
+    POSITIONS,
+    EDGES
+};
+
+uint64_t GraphGenerator::Random::next() {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+qreal GraphGenerator::Random::real() {
+    return (next() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+uint64_t GraphGenerator::Random::below(uint64_t bound) {
+    return uint64_t(real() * bound);
+}
+
+GraphGenerator::Random GraphGenerator::stream(const Options &options, uint64_t purpose, uint64_t task) {
+    Random random = {options.seed ^ (purpose << 48) ^ (task * 0xD1B54A32D192ED03ull)};
+    random.next();
+    return random;
+}
+
+bool GraphGenerator::parse(const QString &spec, Options &options, QString &error) {
+    const QStringList kinds = {"rmat", "grid", "geometric", "random", "chain"};
+    QStringList words = spec.simplified().split(' ');
+    options = Options();
+
+    if (words.size() < 2) {
+        error = "expected \"<kind> <vertices> [edges] [seed=<n>] [weights=<distribution>]\"";
+        return false;
+    }
+
+    int kind = kinds.indexOf(words[0].toLower());
+    if (kind < 0) {
+        error = "unknown kind \"" + words[0] + "\"";
+        return false;
+    }
+    options.kind = Kind(kind);
+
+    bool ok = false;
+    options.vertexCount = words[1].toInt(&ok);
+    if (!ok || options.vertexCount < 1 || options.vertexCount > MAX_VERTICES) {
+        error = "the vertex count must be between 1 and " + QString::number(MAX_VERTICES);
+        return false;
+    }
+
+    const size_t defaultDegree[] = {8, 0, 6, 4, 0};
+    options.edgeCount = defaultDegree[kind] * options.vertexCount;
+
+    for (int i = 2; i < words.size(); ++i) {
+        const QString& word = words[i];
+        QStringList parts = word.split(':');
+
+        if (word.startsWith("seed=")) {
+            options.seed = word.mid(5).toULongLong(&ok);
+        }
+        else if (word == "weights=length") {
+            options.weightKind = LENGTH;
+        }
+        else if (word.startsWith("weights=exp:") && parts.size() == 2) {
+            options.weightKind = EXPONENTIAL;
+            options.weightMax = parts[1].toDouble(&ok);
+            ok = ok && options.weightMax > 0;
+        }
+        else if ((word.startsWith("weights=uniform:") || word.startsWith("weights=real:")) && parts.size() == 3) {
+            options.weightKind = word.startsWith("weights=uniform:") ? UNIFORM : REAL;
+            bool isMaxValid = false;
+            options.weightMin = parts[1].toDouble(&ok);
+            options.weightMax = parts[2].toDouble(&isMaxValid);
+            ok = ok && isMaxValid && options.weightMin >= 0 && options.weightMin <= options.weightMax;
+        }
+        else if (i == 2 && (options.kind == GRID || options.kind == CHAIN)) {
+            error = "the number of edges of a " + words[0] + " is fixed";
+            return false;
+        }
+        else if (i == 2) {
+            options.edgeCount = word.toULongLong(&ok);
+        }
+        else {
+            ok = false;
+        }
+
+        if (!ok) {
+            error = "cannot read \"" + word + "\"";
+            return false;
+        }
+    }
+
+    if (options.edgeCount > MAX_EDGES) {
+        error = "the edge count must be at most " + QString::number(MAX_EDGES);
+        return false;
+    }
+    // Every pair drawn from a single vertex is a loop, so the draws would never end
+    if ((options.kind == RMAT || options.kind == RANDOM) && options.edgeCount > 0 && options.vertexCount < 2) {
+        error = "edges need at least 2 vertices";
+        return false;
+    }
+
+    if (options.weightKind == UNIFORM) {
+        options.weightMin = std::ceil(options.weightMin);
+        options.weightMax = std::floor(options.weightMax);
+        if (options.weightMin > options.weightMax) {
+            error = "no integer weight in the uniform range";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+qreal GraphGenerator::weight(const Options &options, Random &random, QPointF from, QPointF to) {
+    switch (options.weightKind) {
+    case REAL:
+        return options.weightMin + random.real() * (options.weightMax - options.weightMin);
+    case EXPONENTIAL:
+        return -std::log(1 - random.real()) * options.weightMax;
+    case LENGTH:
+        return std::max<qreal>(1, std::round(QLineF(from, to).length()));
+    default:
+        return options.weightMin + random.below(options.weightMax - options.weightMin + 1);
+    }
+}
+
+// Runs function(task, edges) for every task in parallel and joins the
+// per-task lists in task order
+template <typename Function>
+std::vector<GraphLoader::Link> GraphGenerator::generateEdges(size_t tasks, const Function& function) {
+    std::vector<std::vector<Link>> parts(tasks);
+    parallel::forEach(tasks, [&](size_t task) {
+        function(task, parts[task]);
+    });
+
+    size_t total = 0;
+    for (const std::vector<Link>& part : parts) {
+        total += part.size();
+    }
+
+    std::vector<Link> edges;
+    edges.reserve(total);
+    for (std::vector<Link>& part : parts) {
+        edges.insert(edges.end(), part.begin(), part.end());
+        std::vector<Link>().swap(part);
+    }
+
+    return edges;
+}
+
+// Uniformly in a square that gives every vertex SPACING² of room
+void GraphGenerator::scatter(const Options &options, std::vector<QPointF> &positions) {
+    const qreal side = std::sqrt(qreal(positions.size())) * SPACING;
+    const size_t tasks = (positions.size() + TASK_SIZE - 1) / TASK_SIZE;
+
+    parallel::forEach(tasks, [&](size_t task) {
+        Random random = stream(options, POSITIONS, task);
+        size_t end = std::min(positions.size(), (task + 1) * TASK_SIZE);
+        for (size_t i = task * TASK_SIZE; i < end; ++i) {
+            positions[i] = {random.real() * side, random.real() * side};
+        }
+    });
+}
+
+// Recursive matrix: every edge picks one adjacency-matrix quadrant per bit
+// of the vertex ids, which gives the skewed degrees of real networks
+std::vector<GraphLoader::Link> GraphGenerator::rmat(const Options &options, const std::vector<QPointF> &positions) {
+    const size_t count = positions.size();
+    int scale = 0;
+    while ((size_t(1) << scale) < count) ++scale;
+
+    const size_t tasks = (options.edgeCount + TASK_SIZE - 1) / TASK_SIZE;
+    return generateEdges(tasks, [&](size_t task, std::vector<Link> &edges) {
+        Random random = stream(options, EDGES, task);
+        size_t target = std::min(TASK_SIZE, options.edgeCount - task * TASK_SIZE);
+
+        while (edges.size() < target) {
+            size_t from = 0;
+            size_t to = 0;
+            for (int bit = 0; bit < scale; ++bit) {
+                qreal p = random.real();
+                bool isLowerHalf = p >= RMAT_A + RMAT_B;
+                bool isRightHalf = (p >= RMAT_A && p < RMAT_A + RMAT_B) || p >= RMAT_A + RMAT_B + RMAT_C;
+                from = from << 1 | isLowerHalf;
+                to = to << 1 | isRightHalf;
+            }
+
+            if (from >= count || to >= count || from == to) continue;
+            edges.push_back({int(from), int(to), weight(options, random, positions[from], positions[to])});
+        }
+    });
+}
+
+// Jittered lattice with two-way streets to the right and down neighbours
+std::vector<GraphLoader::Link> GraphGenerator::grid(const Options &options, std::vector<QPointF> &positions) {
+    const size_t count = positions.size();
+    const size_t columns = std::ceil(std::sqrt(qreal(count)));
+    const size_t tasks = (count + TASK_SIZE - 1) / TASK_SIZE;
+
+    parallel::forEach(tasks, [&](size_t task) {
+        Random random = stream(options, POSITIONS, task);
+        size_t end = std::min(count, (task + 1) * TASK_SIZE);
+        for (size_t i = task * TASK_SIZE; i < end; ++i) {
+            QPointF jitter = QPointF(random.real() - 0.5, random.real() - 0.5) * (SPACING / 2);
+            positions[i] = QPointF((i % columns) * SPACING, (i / columns) * SPACING) + jitter;
+        }
+    });
+
+    return generateEdges(tasks, [&](size_t task, std::vector<Link> &edges) {
+        Random random = stream(options, EDGES, task);
+        size_t end = std::min(count, (task + 1) * TASK_SIZE);
+
+        for (size_t i = task * TASK_SIZE; i < end; ++i) {
+            for (size_t neighbour : {i + 1, i + columns}) {
+                bool isInGrid = neighbour < count && (neighbour == i + columns || neighbour % columns);
+                if (!isInGrid || random.real() < GRID_GAPS) continue;
+
+                qreal w = weight(options, random, positions[i], positions[neighbour]);
+                edges.push_back({int(i), int(neighbour), w});
+                edges.push_back({int(neighbour), int(i), w});
+            }
+        }
+    });
+}
+
+// Two-way edges between every pair closer than a radius chosen for the
+// requested edge count, found through a grid of radius-sized cells
+std::vector<GraphLoader::Link> GraphGenerator::geometric(const Options &options, const std::vector<QPointF> &positions) {
+    const size_t count = positions.size();
+    const qreal pi = std::acos(qreal(-1));
+    const qreal side = std::sqrt(qreal(count)) * SPACING;
+    const qreal radius = std::sqrt(qreal(options.edgeCount) / count * side * side / (pi * count));
+
+    const size_t cellsPerSide = std::max<size_t>(1, size_t(std::min(side / radius, std::sqrt(qreal(count)))));
+    const qreal cellSize = side / cellsPerSide;
+    auto cellOf = [&](qreal coordinate) {
+        return std::min(cellsPerSide - 1, size_t(std::max<qreal>(0, coordinate / cellSize)));
+    };
+
+    // Counting sort of the vertices by cell
+    std::vector<size_t> cellStart(cellsPerSide * cellsPerSide + 1, 0);
+    std::vector<size_t> cells(count);
+    for (size_t i = 0; i < count; ++i) {
+        cells[i] = cellOf(positions[i].y()) * cellsPerSide + cellOf(positions[i].x());
+        ++cellStart[cells[i] + 1];
+    }
+    for (size_t cell = 0; cell < cellsPerSide * cellsPerSide; ++cell) {
+        cellStart[cell + 1] += cellStart[cell];
+    }
+    std::vector<int> byCell(count);
+    std::vector<size_t> fill(cellStart.begin(), cellStart.end() - 1);
+    for (size_t i = 0; i < count; ++i) {
+        byCell[fill[cells[i]]++] = i;
+    }
+
+    const size_t tasks = (count + TASK_SIZE - 1) / TASK_SIZE;
+    return generateEdges(tasks, [&](size_t task, std::vector<Link> &edges) {
+        Random random = stream(options, EDGES, task);
+        size_t end = std::min(count, (task + 1) * TASK_SIZE);
+
+        for (size_t i = task * TASK_SIZE; i < end; ++i) {
+            size_t row = cells[i] / cellsPerSide;
+            size_t column = cells[i] % cellsPerSide;
+
+            for (size_t y = row ? row - 1 : 0; y <= std::min(row + 1, cellsPerSide - 1); ++y) {
+                for (size_t x = column ? column - 1 : 0; x <= std::min(column + 1, cellsPerSide - 1); ++x) {
+                    size_t cell = y * cellsPerSide + x;
+
+                    for (size_t k = cellStart[cell]; k < cellStart[cell + 1]; ++k) {
+                        size_t j = byCell[k];
+                        if (j <= i || QLineF(positions[i], positions[j]).length() > radius) continue;
+
+                        qreal w = weight(options, random, positions[i], positions[j]);
+                        edges.push_back({int(i), int(j), w});
+                        edges.push_back({int(j), int(i), w});
+                    }
+                }
+            }
+        }
+    });
+}
+
+// Erdős–Rényi G(n, m): endpoints drawn uniformly
+std::vector<GraphLoader::Link> GraphGenerator::random(const Options &options, const std::vector<QPointF> &positions) {
+    const size_t count = positions.size();
+    const size_t tasks = (options.edgeCount + TASK_SIZE - 1) / TASK_SIZE;
+
+    return generateEdges(tasks, [&](size_t task, std::vector<Link> &edges) {
+        Random random = stream(options, EDGES, task);
+        size_t target = std::min(TASK_SIZE, options.edgeCount - task * TASK_SIZE);
+
+        while (edges.size() < target) {
+            size_t from = random.below(count);
+            size_t to = random.below(count);
+            if (from == to) continue;
+
+            edges.push_back({int(from), int(to), weight(options, random, positions[from], positions[to])});
+        }
+    });
+}
+
+// One long path, laid out as a snake so it fits on screen
+std::vector<GraphLoader::Link> GraphGenerator::chain(const Options &options, std::vector<QPointF> &positions) {
+    const size_t count = positions.size();
+    const size_t columns = std::ceil(std::sqrt(qreal(count)));
+    const size_t tasks = (count + TASK_SIZE - 1) / TASK_SIZE;
+
+    for (size_t i = 0; i < count; ++i) {
+        size_t row = i / columns;
+        size_t column = row % 2 ? columns - 1 - i % columns : i % columns;
+        positions[i] = QPointF(column * SPACING, row * SPACING);
+    }
+
+    return generateEdges(tasks, [&](size_t task, std::vector<Link> &edges) {
+        Random random = stream(options, EDGES, task);
+        size_t end = std::min(count - 1, (task + 1) * TASK_SIZE);
+
+        for (size_t i = task * TASK_SIZE; i < end; ++i) {
+            edges.push_back({int(i), int(i + 1), weight(options, random, positions[i], positions[i + 1])});
+        }
+    });
+}
+
+GraphLoader::Batch GraphGenerator::generate(const Options &options) {
+    TRACE_SCOPE("GraphGenerator::generate");
+    GraphLoader::Batch graph;
+    graph.vertices.resize(options.vertexCount);
+
+    if (options.kind == GRID) {
+        graph.edges = grid(options, graph.vertices);
+    }
+    else if (options.kind == CHAIN) {
+        graph.edges = chain(options, graph.vertices);
+    }
+    else {
+        scatter(options, graph.vertices);
+        if (options.vertexCount < 2) return graph;
+
+        if (options.kind == RMAT) graph.edges = rmat(options, graph.vertices);
+        else if (options.kind == GEOMETRIC) graph.edges = geometric(options, graph.vertices);
+        else graph.edges = random(options, graph.vertices);
+    }
+
+    return graph;
+}
@@ -0,0 +1,93 @@
+#ifndef GRAPHGENERATOR_H
+#define GRAPHGENERATOR_H
+
+#include "graphloader.h"
+
+#include <cstdint>
+#include <vector>
+
+#include <QString>
+
+// Seeded synthetic graphs for stress and scale tests, described by a spec:
+//
+//     <kind> <vertices> [edges] [seed=<n>] [weights=<distribution>]
+//
+// kinds:         rmat, grid, geometric, random, chain
+// distributions: uniform:<min>:<max> (integers), real:<min>:<max>,
+//                exp:<mean>, length (rounded edge length)
+//
+// Work is split into fixed-size tasks with their own random streams, so the
+// result depends only on the spec, not on the number of threads.
+class GraphGenerator {
+
+public:
+    enum Kind {
+        RMAT,
+        GRID,
+        GEOMETRIC,
+        RANDOM,
+        CHAIN
+    };
+
+    enum WeightKind {
+        UNIFORM,
+        REAL,
+        EXPONENTIAL,
+        LENGTH
+    };
+
+    struct Options {
+        Kind kind = RANDOM;
+        int vertexCount = 0;
+        size_t edgeCount = 0;
+        uint64_t seed = 1;
+        WeightKind weightKind = UNIFORM;
+        qreal weightMin = 1;
+        qreal weightMax = 100;
+    };
+
+    static bool parse(const QString &spec, Options &options, QString &error);
+    static GraphLoader::Batch generate(const Options &options);
+
+    static constexpr size_t TASK_SIZE = 1 << 16;
+    static constexpr int MAX_VERTICES = 1 << 26;
+    // Room for the default degree of an R-MAT graph of MAX_VERTICES
+    static constexpr size_t MAX_EDGES = size_t(1) << 29;
+    // Average distance between neighbouring vertices on the canvas
+    static constexpr qreal SPACING = 150;
+
+    // R-MAT quadrant probabilities; the last one is 1 - A - B - C
+    static constexpr qreal RMAT_A = 0.57;
+    static constexpr qreal RMAT_B = 0.19;
+    static constexpr qreal RMAT_C = 0.19;
+
+    // Share of grid streets left out, so the grid looks more like roads
+    static constexpr qreal GRID_GAPS = 0.1;
+
+private:
+    // SplitMix64: tiny state, so every task can own a stream
+    struct Random {
+        uint64_t state;
+
+        uint64_t next();
+        qreal real();
+        uint64_t below(uint64_t bound);
+    };
+
+    typedef GraphLoader::Link Link;
+
+    static Random stream(const Options &options, uint64_t purpose, uint64_t task);
+    static qreal weight(const Options &options, Random &random, QPointF from, QPointF to);
+
+    template <typename Function>
+    static std::vector<Link> generateEdges(size_t tasks, const Function& function);
+
+    static void scatter(const Options &options, std::vector<QPointF> &positions);
+    static std::vector<Link> rmat(const Options &options, const std::vector<QPointF> &positions);
+    static std::vector<Link> grid(const Options &options, std::vector<QPointF> &positions);
+    static std::vector<Link> geometric(const Options &options, const std::vector<QPointF> &positions);
+    static std::vector<Link> random(const Options &options, const std::vector<QPointF> &positions);
+    static std::vector<Link> chain(const Options &options, std::vector<QPointF> &positions);
+};
+
+#endif // GRAPHGENERATOR_H
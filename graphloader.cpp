@@ -0,0 +1,209 @@
+#include "graphloader.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include <QByteArray>
+#include <QFile>
+#include <QLocale>
+#include <QTextStream>
+
+GraphLoader::~GraphLoader() {
+    stop();
+}
+
+void GraphLoader::start(const QString &path) {
+    stop();
+
+    published = Batch();
+    error.clear();
+    stopRequested = false;
+    running = true;
+    worker = std::thread(&GraphLoader::run, this, path);
+}
+
+void GraphLoader::startGenerated(const std::function<Batch()> &generate) {
+    stop();
+
+    published = Batch();
+    error.clear();
+    stopRequested = false;
+    running = true;
+    worker = std::thread(&GraphLoader::runGenerated, this, generate);
+}
+
+void GraphLoader::stop() {
+    {
+        std::lock_guard<std::mutex> lock(publishMutex);
+        stopRequested = true;
+    }
+    taken.notify_all();
+
+    if (worker.joinable()) worker.join();
+    running = false;
+}
+
+bool GraphLoader::takeBatch(Batch &batch) {
+    {
+        std::lock_guard<std::mutex> lock(publishMutex);
+        if (published.size() == 0) return false;
+
+        batch = std::move(published);
+        published = Batch();
+    }
+    taken.notify_all();
+
+    return true;
+}
+
+QString GraphLoader::getError() {
+    std::lock_guard<std::mutex> lock(publishMutex);
+    return error;
+}
+
+void GraphLoader::publish(Batch &batch) {
+    std::unique_lock<std::mutex> lock(publishMutex);
+    taken.wait(lock, [&]() { return stopRequested || published.size() < MAX_PENDING; });
+
+    published.vertices.insert(published.vertices.end(), batch.vertices.begin(), batch.vertices.end());
+    published.edges.insert(published.edges.end(), batch.edges.begin(), batch.edges.end());
+    batch.vertices.clear();
+    batch.edges.clear();
+}
+
+// Splits the line in place; returns false with a message on a bad record
+bool GraphLoader::parseLine(char *line, int vertexCount, Batch &batch, QString &message) {
+    const char *tokens[5];
+    int count = 0;
+
+    for (char *c = line; *c && count < 5; ) {
+        while (*c == ' ' || *c == '\t' || *c == '\r' || *c == '\n') *c++ = '\0';
+        if (!*c) break;
+
+        tokens[count++] = c;
+        while (*c && *c != ' ' && *c != '\t' && *c != '\r' && *c != '\n') ++c;
+    }
+
+    if (count == 0 || tokens[0][0] == '#') return true;
+
+    bool isValid = true;
+    auto real = [&](const char *token) {
+        bool ok = false;
+        qreal value = QByteArray::fromRawData(token, qstrlen(token)).toDouble(&ok);
+        isValid = isValid && ok && qIsFinite(value);
+        return value;
+    };
+    auto integer = [&](const char *token) {
+        bool ok = false;
+        int value = QByteArray::fromRawData(token, qstrlen(token)).toInt(&ok);
+        isValid = isValid && ok;
+        return value;
+    };
+
+    if (qstrcmp(tokens[0], "v") == 0 && count == 3) {
+        QPointF pos = {real(tokens[1]), real(tokens[2])};
+        if (isValid) batch.vertices.push_back(pos);
+    }
+    else if (qstrcmp(tokens[0], "e") == 0 && count == 4) {
+        Link link = {integer(tokens[1]), integer(tokens[2]), real(tokens[3])};
+
+        if (isValid && (link.from < 0 || link.from >= vertexCount || link.to < 0 || link.to >= vertexCount)) {
+            message = QString("unknown vertex in \"e %1 %2\"").arg(link.from).arg(link.to);
+            return false;
+        }
+        if (isValid && link.weight < 0) {
+            message = "negative weight";
+            return false;
+        }
+        if (isValid) batch.edges.push_back(link);
+    }
+    else {
+        isValid = false;
+    }
+
+    if (!isValid) message = "expected \"v <x> <y>\" or \"e <from> <to> <weight>\"";
+    return isValid;
+}
+
+void GraphLoader::run(QString path) {
+    TRACE_SCOPE("GraphLoader::run");
+    QString message;
+    QFile file(path);
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        message = file.errorString();
+    }
+    else {
+        Batch batch;
+        int vertexCount = 0;
+        int lineNumber = 0;
+        char line[LINE_LENGTH];
+
+        while (!stopRequested) {
+            qint64 length = file.readLine(line, sizeof(line));
+            if (length <= 0) break;
+            ++lineNumber;
+
+            if (line[length - 1] != '\n' && !file.atEnd()) {
+                message = QString("line %1: longer than %2 characters").arg(lineNumber).arg(LINE_LENGTH - 2);
+                break;
+            }
+
+            size_t vertices = batch.vertices.size();
+            if (!parseLine(line, vertexCount, batch, message)) {
+                message = QString("line %1: %2").arg(lineNumber).arg(message);
+                break;
+            }
+            vertexCount += batch.vertices.size() - vertices;
+
+            if (batch.size() >= BATCH_SIZE) publish(batch);
+        }
+
+        publish(batch);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(publishMutex);
+        error = message;
+    }
+    running = false;
+}
+
+void GraphLoader::runGenerated(std::function<Batch()> generate) {
+    Batch graph = generate();
+    Batch batch;
+
+    // All vertices first, so every edge refers to a published vertex
+    for (size_t i = 0; i < graph.vertices.size() && !stopRequested; i += BATCH_SIZE) {
+        size_t end = std::min(graph.vertices.size(), i + BATCH_SIZE);
+        batch.vertices.assign(graph.vertices.begin() + i, graph.vertices.begin() + end);
+        publish(batch);
+    }
+    for (size_t i = 0; i < graph.edges.size() && !stopRequested; i += BATCH_SIZE) {
+        size_t end = std::min(graph.edges.size(), i + BATCH_SIZE);
+        batch.edges.assign(graph.edges.begin() + i, graph.edges.begin() + end);
+        publish(batch);
+    }
+
+    running = false;
+}
+
+bool GraphLoader::save(const GraphSnapshot &graph, const QString &path) {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) return false;
+
+    QTextStream out(&file);
+    auto number = [](qreal value) { return QString::number(value, 'g', QLocale::FloatingPointShortest); };
+
+    std::unordered_map<int, int> index;
+    graph.forEachVertex([&](const VertexRecord &vertex) {
+        index.insert({vertex.id, int(index.size())});
+        out << "v " << number(vertex.pos.x()) << " " << number(vertex.pos.y()) << "\n";
+    });
+    graph.forEachEdge([&](const EdgeRecord &edge) {
+        out << "e " << index.at(edge.startId) << " " << index.at(edge.endId) << " " << number(edge.weight) << "\n";
+    });
+
+    return true;
+}
@@ -0,0 +1,72 @@
+#ifndef GRAPHLOADER_H
+#define GRAPHLOADER_H
+
+#include "graphsnapshot.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <QString>
+
+// Reads a graph file, or builds a generated graph, on a worker thread and
+// hands it over in batches, so the canvas shows the first part long before
+// the last line is parsed.
+// The format is one record per line, with vertices numbered from 0 in the
+// order they appear:
+//
+//     # comment
+//     v <x> <y>
+//     e <from> <to> <weight>
+class GraphLoader {
+
+public:
+    struct Link {
+        int from;
+        int to;
+        qreal weight;
+    };
+
+    struct Batch {
+        std::vector<QPointF> vertices;
+        std::vector<Link> edges;
+
+        size_t size() const { return vertices.size() + edges.size(); }
+    };
+
+    ~GraphLoader();
+
+    void start(const QString &path);
+    void startGenerated(const std::function<Batch()> &generate);
+    void stop();
+    bool isRunning() const { return running; }
+    bool takeBatch(Batch &batch);
+    QString getError();
+
+    static bool save(const GraphSnapshot &graph, const QString &path);
+
+    const size_t BATCH_SIZE = 16384;
+    // The worker waits while this many records are still untaken
+    const size_t MAX_PENDING = 65536;
+    static constexpr int LINE_LENGTH = 256;
+
+private:
+    void run(QString path);
+    void runGenerated(std::function<Batch()> generate);
+    void publish(Batch &batch);
+    bool parseLine(char *line, int vertexCount, Batch &batch, QString &error);
+
+    std::thread worker;
+    std::atomic<bool> running{false};
+    std::atomic<bool> stopRequested{false};
+
+    std::mutex publishMutex;
+    std::condition_variable taken;
+    Batch published;
+    QString error;
+};
+
+#endif // GRAPHLOADER_H
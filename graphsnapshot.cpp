@@ -0,0 +1,83 @@
+#include "utils.h"
+#include "graphsnapshot.h"
+#include "memoryreport.h"
+
+void GraphModel::addVertex(int id, QPointF pos) {
+    VertexRecord record;
+    record.id = id;
+    record.pos = pos;
+    current.vertices.insert(id, std::move(record));
+    ++current.version;
+}
+
+void GraphModel::moveVertex(int id, QPointF pos) {
+    if (!current.vertices.find(id)) return;
+    current.vertices.edit(id)->pos = pos;
+}
+
+void GraphModel::removeVertex(int id) {
+    const VertexRecord *vertex = current.vertices.find(id);
+    if (!vertex) return;
+
+    std::vector<int> incident = vertex->in.edgeId;
+    incident.insert(incident.end(), vertex->out.edgeId.begin(), vertex->out.edgeId.end());
+    for (int edgeId : incident) {
+        removeEdge(edgeId);
+    }
+
+    current.vertices.erase(id);
+    ++current.version;
+}
+
+void GraphModel::addEdge(int id, int startId, int endId, qreal weight) {
+    VertexRecord *start = current.vertices.edit(startId);
+    VertexRecord *end = current.vertices.edit(endId);
+
+    current.edges.insert(id, EdgeRecord{id, startId, endId, weight, start->out.edgeId.size(), end->in.edgeId.size()});
+
+    start->out.vertexId.push_back(endId);
+    start->out.edgeId.push_back(id);
+    end->in.vertexId.push_back(startId);
+    end->in.edgeId.push_back(id);
+
+    ++current.version;
+}
+
+void GraphModel::removeEdge(int id) {
+    const EdgeRecord *edge = current.edges.find(id);
+    if (!edge) return;
+
+    int startId = edge->startId;
+    int endId = edge->endId;
+    size_t outSlot = edge->outSlot;
+    size_t inSlot = edge->inSlot;
+
+    VertexRecord *start = current.vertices.edit(startId);
+    utils::swapAndPop(start->out.vertexId, start->out.edgeId, outSlot);
+    if (outSlot < start->out.edgeId.size()) {
+        current.edges.edit(start->out.edgeId[outSlot])->outSlot = outSlot;
+    }
+
+    VertexRecord *end = current.vertices.edit(endId);
+    utils::swapAndPop(end->in.vertexId, end->in.edgeId, inSlot);
+    if (inSlot < end->in.edgeId.size()) {
+        current.edges.edit(end->in.edgeId[inSlot])->inSlot = inSlot;
+    }
+
+    current.edges.erase(id);
+    ++current.version;
+}
+
+size_t GraphSnapshot::memoryUsage() const {
+    auto vertexBytes = [](const VertexRecord &vertex) {
+        return MemoryReport::vectorBytes(vertex.in.vertexId) + MemoryReport::vectorBytes(vertex.in.edgeId)
+               + MemoryReport::vectorBytes(vertex.out.vertexId) + MemoryReport::vectorBytes(vertex.out.edgeId);
+    };
+    auto edgeBytes = [](const EdgeRecord &) { return size_t(0); };
+
+    return vertices.memoryUsage(MemoryReport::heapBytes, vertexBytes) + edges.memoryUsage(MemoryReport::heapBytes, edgeBytes);
+}
+
+std::shared_ptr<const GraphSnapshot> GraphModel::snapshot() const {
+    return std::make_shared<const GraphSnapshot>(current);
+}
@@ -0,0 +1,153 @@
+#ifndef GRAPHSNAPSHOT_H
+#define GRAPHSNAPSHOT_H
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include <QPointF>
+
+struct VertexRecord {
+    int id;
+    QPointF pos;
+
+    struct {
+        std::vector<int> vertexId;
+        std::vector<int> edgeId;
+    } in, out;
+};
+
+struct EdgeRecord {
+    int id;
+    int startId;
+    int endId;
+    qreal weight;
+    size_t outSlot;
+    size_t inSlot;
+};
+
+// Records indexed by id and split into fixed-size chunks. Copying a table
+// only copies chunk pointers; a chunk or record is cloned on the first edit
+// made while another copy still shares it.
+template <typename Record>
+class RecordTable {
+
+public:
+    const Record* find(int id) const {
+        size_t chunk = id / CHUNK_SIZE;
+        if (id < 0 || chunk >= chunks.size() || !chunks[chunk]) return nullptr;
+        return (*chunks[chunk])[id % CHUNK_SIZE].get();
+    }
+
+    Record* edit(int id) {
+        std::shared_ptr<const Record>& slot = editChunk(id / CHUNK_SIZE)[id % CHUNK_SIZE];
+        if (slot.use_count() > 1) slot = std::make_shared<const Record>(*slot);
+        return const_cast<Record*>(slot.get());
+    }
+
+    void insert(int id, Record record) {
+        if (size_t(id / CHUNK_SIZE) >= chunks.size()) chunks.resize(id / CHUNK_SIZE + 1);
+
+        std::shared_ptr<const Record>& slot = editChunk(id / CHUNK_SIZE)[id % CHUNK_SIZE];
+        if (!slot) ++count;
+        slot = std::make_shared<const Record>(std::move(record));
+    }
+
+    void erase(int id) {
+        if (!find(id)) return;
+
+        editChunk(id / CHUNK_SIZE)[id % CHUNK_SIZE].reset();
+        --count;
+    }
+
+    size_t size() const { return count; }
+    int idBound() const { return chunks.size() * CHUNK_SIZE; }
+
+    template <typename Function>
+    void forEach(const Function& function) const {
+        for (const auto& chunk : chunks) {
+            if (!chunk) continue;
+            for (const auto& record : *chunk) {
+                if (record) function(*record);
+            }
+        }
+    }
+
+    // Chunk index, chunks and records, each allocation sized by
+    // allocationBytes; recordBytes adds what a record owns itself
+    template <typename Allocation, typename Function>
+    size_t memoryUsage(const Allocation& allocationBytes, const Function& recordBytes) const {
+        const size_t controlBlock = 2 * sizeof(long);
+        size_t bytes = allocationBytes(chunks.capacity() * sizeof(std::shared_ptr<Chunk>));
+        for (const auto& chunk : chunks) {
+            if (!chunk) continue;
+            bytes += allocationBytes(controlBlock + sizeof(Chunk));
+            for (const auto& record : *chunk) {
+                if (record) bytes += allocationBytes(controlBlock + sizeof(Record)) + recordBytes(*record);
+            }
+        }
+        return bytes;
+    }
+
+    static constexpr int CHUNK_SIZE = 256;
+
+private:
+    typedef std::array<std::shared_ptr<const Record>, CHUNK_SIZE> Chunk;
+
+    Chunk& editChunk(size_t chunk) {
+        if (!chunks[chunk]) chunks[chunk] = std::make_shared<Chunk>();
+        else if (chunks[chunk].use_count() > 1) chunks[chunk] = std::make_shared<Chunk>(*chunks[chunk]);
+        return *chunks[chunk];
+    }
+
+    std::vector<std::shared_ptr<Chunk>> chunks;
+    size_t count = 0;
+};
+
+// Immutable view of the graph handed to algorithms. It stays valid while
+// the canvas keeps editing the model it was taken from.
+class GraphSnapshot {
+
+public:
+    const VertexRecord* vertex(int id) const { return vertices.find(id); }
+    const EdgeRecord* edge(int id) const { return edges.find(id); }
+    size_t vertexCount() const { return vertices.size(); }
+    size_t edgeCount() const { return edges.size(); }
+    int vertexIdBound() const { return vertices.idBound(); }
+    int getVersion() const { return version; }
+    size_t memoryUsage() const;
+
+    template <typename Function>
+    void forEachVertex(const Function& function) const { vertices.forEach(function); }
+
+    template <typename Function>
+    void forEachEdge(const Function& function) const { edges.forEach(function); }
+
+private:
+    friend class GraphModel;
+
+    RecordTable<VertexRecord> vertices;
+    RecordTable<EdgeRecord> edges;
+    int version = 0;
+};
+
+// The editable version of the graph, mirrored by Canvas on every mutation.
+// The version only changes with structure and weights, not with positions.
+class GraphModel {
+
+public:
+    void addVertex(int id, QPointF pos);
+    void moveVertex(int id, QPointF pos);
+    void removeVertex(int id);
+    void addEdge(int id, int startId, int endId, qreal weight);
+    void removeEdge(int id);
+
+    int getVersion() const { return current.version; }
+    size_t memoryUsage() const { return current.memoryUsage(); }
+    std::shared_ptr<const GraphSnapshot> snapshot() const;
+
+private:
+    GraphSnapshot current;
+};
+
+#endif // GRAPHSNAPSHOT_H
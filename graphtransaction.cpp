@@ -0,0 +1,33 @@
+#include "graphtransaction.h"
+#include "canvas.h"
+
+GraphTransaction::GraphTransaction(Canvas *canvas) : canvas(canvas) {
+    firstVertexId = canvas->totalVertices;
+}
+
+int GraphTransaction::addVertex(QPointF pos) {
+    vertexInserts.push_back(pos);
+    return firstVertexId + vertexInserts.size() - 1;
+}
+
+void GraphTransaction::addEdge(int startId, int endId, qreal weight) {
+    edgeInserts.push_back({startId, endId, weight});
+}
+
+void GraphTransaction::removeEdge(int id) {
+    edgeDeletes.push_back(id);
+}
+
+void GraphTransaction::removeVertex(int id) {
+    vertexDeletes.push_back(id);
+}
+
+void GraphTransaction::commit() {
+    canvas->applyTransaction(*this);
+
+    firstVertexId = canvas->totalVertices;
+    vertexInserts.clear();
+    edgeInserts.clear();
+    edgeDeletes.clear();
+    vertexDeletes.clear();
+}
@@ -0,0 +1,40 @@
+#ifndef GRAPHTRANSACTION_H
+#define GRAPHTRANSACTION_H
+
+#include <vector>
+
+#include <QPointF>
+
+class Canvas;
+
+// Queues graph mutations and applies them in one pass on commit, with a
+// single duplicate check, one analysis invalidation and one repaint.
+class GraphTransaction {
+
+public:
+    GraphTransaction(Canvas *canvas);
+
+    int addVertex(QPointF pos);
+    void addEdge(int startId, int endId, qreal weight);
+    void removeEdge(int id);
+    void removeVertex(int id);
+    void commit();
+
+private:
+    friend class Canvas;
+
+    struct PendingEdge {
+        int startId;
+        int endId;
+        qreal weight;
+    };
+
+    Canvas *canvas;
+    int firstVertexId;
+    std::vector<QPointF> vertexInserts;
+    std::vector<PendingEdge> edgeInserts;
+    std::vector<int> edgeDeletes;
+    std::vector<int> vertexDeletes;
+};
+
+#endif // GRAPHTRANSACTION_H
@@ -0,0 +1,186 @@
+#include "kshortestpaths.h"
+#include "parallel.h"
+#include "queryworkspace.h"
+#include "trace.h"
+
+#include <algorithm>
+
+KShortestPaths::KShortestPaths(const GraphSnapshot &snapshot) : graph(std::make_shared<const FlatGraph<qreal>>(snapshot)) {
+    std::vector<int> order(graph->size());
+    for (int vertex = 0; vertex < graph->size(); ++vertex) {
+        order[vertex] = graph->idAt(vertex);
+    }
+    reversed = std::make_shared<const FlatGraph<qreal>>(snapshot, order, true);
+}
+
+KShortestPaths::KShortestPaths(std::shared_ptr<const FlatGraph<qreal>> graph, std::shared_ptr<const FlatGraph<qreal>> reversed)
+    : graph(std::move(graph)), reversed(std::move(reversed)) {
+}
+
+// Shortest distances to the target along reversed edges, and the first edge
+// of a shortest path from every vertex. The tree has a workspace of its own
+// per thread, since the spur searches on this thread take the shared one
+const KShortestPaths::Tree& KShortestPaths::treeTo(int target) const {
+    static thread_local Tree tree;
+    tree.begin(reversed->size());
+    return ShortestPath<FlatGraph<qreal>>::run(*reversed, target, tree);
+}
+
+void KShortestPaths::treePath(const Tree &tree, int start, Path &path) const {
+    path.vertices.push_back(start);
+    path.distances.push_back(0);
+    for (int vertex = start; tree.parent[vertex] != -1; vertex = tree.parent[vertex]) {
+        qreal weight = 0;
+        graph->forEachOut(vertex, [&](int, qreal edgeWeight, int edgeId) {
+            if (edgeId == tree.parentEdge[vertex]) weight = edgeWeight;
+        });
+
+        path.vertices.push_back(tree.parent[vertex]);
+        path.edges.push_back(tree.parentEdge[vertex]);
+        path.distances.push_back(path.distances.back() + weight);
+    }
+}
+
+// Shortest path from the spur vertex of previous to the target that avoids
+// the root before it and the blocked edges leaving it
+bool KShortestPaths::spurPath(const Tree &tree, const Path &previous, size_t spur,
+                              const std::vector<int> &blockedEdges, Path &path) const {
+    const int start = previous.vertices[spur];
+    const int target = previous.vertices.back();
+    if (!tree.isReached(start)) return false;
+
+    QueryWorkspace<qreal>& workspace = QueryWorkspace<qreal>::local(graph->size());
+    for (size_t i = 0; i < spur; ++i) {
+        workspace.block(previous.vertices[i]);
+    }
+
+    auto isBlocked = [&](int edgeId) {
+        return std::find(blockedEdges.begin(), blockedEdges.end(), edgeId) != blockedEdges.end();
+    };
+
+    bool isTreeFree = !isBlocked(tree.parentEdge[start]);
+    for (int vertex = tree.parent[start]; isTreeFree && vertex != -1; vertex = tree.parent[vertex]) {
+        isTreeFree = !workspace.isBlocked(vertex);
+    }
+    if (isTreeFree) {
+        treePath(tree, start, path);
+        return true;
+    }
+
+    // A* with the tree distances as the estimate. Removing vertices and edges
+    // only makes paths longer, so the estimate stays a lower bound
+    workspace.reach(start, 0, -1, -1);
+    workspace.push(tree.distance[start], start);
+    bool isReached = false;
+
+    while (!workspace.heap.empty()) {
+        auto [estimate, vertex] = workspace.pop();
+
+        qreal distance = workspace.distance[vertex];
+        if (estimate > distance + tree.distance[vertex]) continue;
+        if (vertex == target) {
+            isReached = true;
+            break;
+        }
+
+        graph->forEachOut(vertex, [&](int next, qreal weight, int edgeId) {
+            if (workspace.isBlocked(next) || !tree.isReached(next)) return;
+            if (vertex == start && isBlocked(edgeId)) return;
+
+            qreal candidate = distance + weight;
+            if (candidate >= workspace.distanceTo(next)) return;
+
+            workspace.reach(next, candidate, vertex, edgeId);
+            workspace.push(candidate + tree.distance[next], next);
+        });
+    }
+
+    if (!isReached) return false;
+
+    for (int vertex = target; vertex != -1; vertex = workspace.parent[vertex]) {
+        path.vertices.push_back(vertex);
+        path.distances.push_back(workspace.distance[vertex]);
+        if (vertex != start) path.edges.push_back(workspace.parentEdge[vertex]);
+    }
+    std::reverse(path.vertices.begin(), path.vertices.end());
+    std::reverse(path.edges.begin(), path.edges.end());
+    std::reverse(path.distances.begin(), path.distances.end());
+    return true;
+}
+
+std::vector<Route> KShortestPaths::find(int fromId, int toId, int count) const {
+    TRACE_SCOPE("KShortestPaths::find");
+    const int source = graph->indexOf(fromId);
+    const int target = graph->indexOf(toId);
+    if (source < 0 || target < 0 || source == target || count <= 0) return {};
+
+    const Tree& tree = treeTo(target);
+    if (!tree.isReached(source)) return {};
+
+    std::vector<Path> accepted(1);
+    treePath(tree, source, accepted[0]);
+
+    std::vector<Path> candidates;
+
+    auto isKnown = [&](const Path &path) {
+        auto isSame = [&](const Path &other) { return other.edges == path.edges; };
+        return std::any_of(accepted.begin(), accepted.end(), isSame) || std::any_of(candidates.begin(), candidates.end(), isSame);
+    };
+
+    while (accepted.size() < size_t(count)) {
+        const Path& previous = accepted.back();
+        const size_t spurs = previous.edges.size();
+        std::vector<Path> found(spurs);
+        std::vector<char> isFound(spurs, false);
+
+        parallel::forEach(spurs, [&](size_t spur) {
+            std::vector<int> blockedEdges;
+            for (const Path& path : accepted) {
+                if (path.edges.size() > spur && std::equal(previous.edges.begin(), previous.edges.begin() + spur, path.edges.begin())) {
+                    blockedEdges.push_back(path.edges[spur]);
+                }
+            }
+            isFound[spur] = spurPath(tree, previous, spur, blockedEdges, found[spur]);
+        });
+
+        for (size_t spur = 0; spur < spurs; ++spur) {
+            if (!isFound[spur]) continue;
+
+            Path candidate;
+            candidate.vertices.assign(previous.vertices.begin(), previous.vertices.begin() + spur);
+            candidate.edges.assign(previous.edges.begin(), previous.edges.begin() + spur);
+            candidate.distances.assign(previous.distances.begin(), previous.distances.begin() + spur);
+
+            qreal rootLength = previous.distances[spur];
+            candidate.vertices.insert(candidate.vertices.end(), found[spur].vertices.begin(), found[spur].vertices.end());
+            candidate.edges.insert(candidate.edges.end(), found[spur].edges.begin(), found[spur].edges.end());
+            for (qreal distance : found[spur].distances) {
+                candidate.distances.push_back(rootLength + distance);
+            }
+
+            if (!isKnown(candidate)) candidates.push_back(std::move(candidate));
+        }
+
+        if (candidates.empty()) break;
+
+        auto shortest = std::min_element(candidates.begin(), candidates.end(), [](const Path &first, const Path &second) {
+            if (first.distances.back() != second.distances.back()) return first.distances.back() < second.distances.back();
+            return first.edges.size() < second.edges.size();
+        });
+        accepted.push_back(std::move(*shortest));
+        candidates.erase(shortest);
+    }
+
+    std::vector<Route> routes;
+    for (const Path& path : accepted) {
+        Route route;
+        for (int vertex : path.vertices) {
+            route.vertexIds.push_back(graph->idAt(vertex));
+        }
+        route.edgeIds = path.edges;
+        route.distances = path.distances;
+        route.length = path.distances.back();
+        routes.push_back(std::move(route));
+    }
+    return routes;
+}
@@ -0,0 +1,41 @@
+#ifndef KSHORTESTPATHS_H
+#define KSHORTESTPATHS_H
+
+#include "shortestpath.h"
+
+#include <memory>
+#include <vector>
+
+// Loopless routes between two vertices in order of length (Yen). Every
+// spur search of an iteration runs in parallel on its thread's workspace, guided
+// by the shortest-path tree towards the target: its distances are a lower
+// bound that stays valid when root vertices and edges are removed, and a
+// spur whose tree path avoids them needs no search at all.
+class KShortestPaths {
+
+public:
+    KShortestPaths(const GraphSnapshot &snapshot);
+    // Reuses graphs built elsewhere; reversed must be numbered like graph
+    KShortestPaths(std::shared_ptr<const FlatGraph<qreal>> graph, std::shared_ptr<const FlatGraph<qreal>> reversed);
+
+    std::vector<Route> find(int fromId, int toId, int count) const;
+
+private:
+    struct Path {
+        std::vector<int> vertices;
+        std::vector<int> edges;
+        std::vector<qreal> distances;
+    };
+
+    // Distances to the target, the parent of a vertex is its next one
+    typedef QueryWorkspace<qreal> Tree;
+
+    const Tree& treeTo(int target) const;
+    void treePath(const Tree &tree, int start, Path &path) const;
+    bool spurPath(const Tree &tree, const Path &previous, size_t spur, const std::vector<int> &blockedEdges, Path &path) const;
+
+    std::shared_ptr<const FlatGraph<qreal>> graph;
+    std::shared_ptr<const FlatGraph<qreal>> reversed;
+};
+
+#endif // KSHORTESTPATHS_H
@@ -0,0 +1,68 @@
+#include "utils.h"
+#include "labelcache.h"
+#include "memoryreport.h"
+
+#include <QFontMetrics>
+
+void LabelCache::setFont(const QFont &font) {
+    if (hasFont && font == baseFont) return;
+
+    hasFont = true;
+    baseFont = font;
+    regularFont = font;
+    regularFont.setItalic(false);
+    italicFont = font;
+    italicFont.setItalic(true);
+
+    regular.entries.clear();
+    italic.entries.clear();
+}
+
+size_t LabelCache::memoryUsage() const {
+    // Bucket array and one node per label with its key; the glyph layout
+    // inside QStaticText is private to Qt
+    size_t bytes = 0;
+    for (const QHash<QString, Entry>* labels : {&regular.entries, &italic.entries}) {
+        size_t node = sizeof(void*) + sizeof(uint) + sizeof(QString) + sizeof(Entry);
+        bytes += MemoryReport::heapBytes(labels->capacity() * sizeof(void*));
+        for (auto label = labels->constBegin(); label != labels->constEnd(); ++label) {
+            bytes += MemoryReport::heapBytes(node) + MemoryReport::stringBytes(label.key());
+        }
+    }
+    return bytes;
+}
+
+// Keeps what the current frame drew and leaves as much room again
+void LabelCache::evict(Labels &labels) {
+    for (auto entry = labels.entries.begin(); entry != labels.entries.end();) {
+        if (entry->lastFrame == frame) ++entry;
+        else entry = labels.entries.erase(entry);
+    }
+    labels.limit = std::max<int>(MAX_LABELS, 2 * labels.entries.size());
+}
+
+const LabelCache::Label& LabelCache::get(const QString &text, bool isItalic) {
+    Labels& labels = isItalic ? italic : regular;
+
+    auto entry = labels.entries.find(text);
+    if (entry != labels.entries.end()) {
+        entry->lastFrame = frame;
+        return entry->label;
+    }
+
+    // Weights seen during an animation are unbounded, so old ones have to go
+    if (labels.entries.size() >= labels.limit) evict(labels);
+
+    const QFont& font = getFont(isItalic);
+    QFontMetrics metrics(font);
+
+    Label created;
+    created.text = QStaticText(text);
+    created.text.setTextFormat(Qt::PlainText);
+    created.text.setPerformanceHint(QStaticText::AggressiveCaching);
+    created.text.prepare(QTransform(), font);
+    created.centerOffset = utils::getTextCenterAlign(metrics, text);
+    created.ascent = metrics.ascent();
+
+    return labels.entries.insert(text, {created, frame}).value().label;
+}
@@ -0,0 +1,61 @@
+#ifndef LABELCACHE_H
+#define LABELCACHE_H
+
+#include <QFont>
+#include <QHash>
+#include <QPainter>
+#include <QStaticText>
+#include <QString>
+
+#include <cstdint>
+
+// Laid-out vertex names and edge weights, keyed by text. Labels are built
+// once per string and font; changing the font drops the cache. When full,
+// labels not drawn in the current frame are evicted, so a view showing more
+// than MAX_LABELS grows the cache instead of relaying out every frame.
+class LabelCache {
+
+public:
+    struct Label {
+        QStaticText text;
+        QPointF centerOffset;
+        qreal ascent;
+    };
+
+    void setFont(const QFont &font);
+    void beginFrame() { ++frame; }
+    const QFont& getFont(bool isItalic) const { return isItalic ? italicFont : regularFont; }
+    const Label& get(const QString &text, bool isItalic = false);
+    int size() const { return regular.entries.size() + italic.entries.size(); }
+    size_t memoryUsage() const;
+
+    // Draws a label whose baseline starts at textPos, like QPainter::drawText
+    static void draw(QPainter &painter, const QPointF &textPos, const Label &label) {
+        painter.drawStaticText(textPos - QPointF{0, label.ascent}, label.text);
+    }
+
+    static constexpr int MAX_LABELS = 4096;
+
+private:
+    struct Entry {
+        Label label;
+        uint64_t lastFrame;
+    };
+
+    struct Labels {
+        QHash<QString, Entry> entries;
+        int limit = MAX_LABELS;
+    };
+
+    void evict(Labels &labels);
+
+    bool hasFont = false;
+    QFont baseFont;
+    QFont regularFont;
+    QFont italicFont;
+    Labels regular;
+    Labels italic;
+    uint64_t frame = 0;
+};
+
+#endif // LABELCACHE_H
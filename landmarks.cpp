@@ -0,0 +1,179 @@
+#include "landmarks.h"
+#include "parallel.h"
+#include "queryworkspace.h"
+#include "trace.h"
+
+#include <algorithm>
+
+static const qreal INF_DISTANCE = WeightTraits<qreal>::infinity();
+
+std::vector<int> Landmarks::getLandmarkIds() const {
+    std::vector<int> ids;
+    for (int landmark : landmarks) {
+        ids.push_back(graph->idAt(landmark));
+    }
+    return ids;
+}
+
+size_t Landmarks::memoryUsage() const {
+    if (!graph) return 0;
+    return graph->memoryUsage() + reversed->memoryUsage()
+           + (fromLandmark.capacity() + toLandmark.capacity()) * sizeof(qreal);
+}
+
+void Landmarks::build(const GraphSnapshot &snapshot, const std::vector<int> &landmarkIds, size_t count,
+                      const std::vector<int> &order) {
+    TRACE_SCOPE("Landmarks::build");
+    graph = std::make_shared<const FlatGraph<qreal>>(snapshot, order);
+    std::vector<int> ids(graph->size());
+    for (int vertex = 0; vertex < graph->size(); ++vertex) {
+        ids[vertex] = graph->idAt(vertex);
+    }
+    reversed = std::make_shared<const FlatGraph<qreal>>(snapshot, ids, true);
+    version = snapshot.getVersion();
+
+    landmarks.clear();
+    fromLandmark.clear();
+    toLandmark.clear();
+    if (count == 0) return;
+
+    fromLandmark.assign(size_t(graph->size()) * COUNT, INF_DISTANCE);
+    toLandmark.assign(size_t(graph->size()) * COUNT, INF_DISTANCE);
+
+    for (int id : landmarkIds) {
+        if (landmarks.size() == std::min(count, COUNT)) break;
+        int vertex = graph->indexOf(id);
+        if (vertex >= 0 && graph->degree(vertex) + reversed->degree(vertex) > 0) landmarks.push_back(vertex);
+    }
+    computeDistances(0);
+
+    // Each new landmark needs the distances of the ones before it
+    while (landmarks.size() < std::min(count, COUNT)) {
+        int next = farthest();
+        if (next == -1) break;
+
+        landmarks.push_back(next);
+        computeDistances(landmarks.size() - 1);
+    }
+}
+
+// Vertex with edges whose nearest landmark, counting both directions, is
+// farthest away; vertices no landmark connects to come first
+int Landmarks::farthest() const {
+    int best = -1;
+    qreal bestScore = 0;
+
+    for (int vertex = 0; vertex < graph->size(); ++vertex) {
+        if (graph->degree(vertex) + reversed->degree(vertex) == 0) continue;
+
+        const qreal *from = &fromLandmark[size_t(vertex) * COUNT];
+        const qreal *to = &toLandmark[size_t(vertex) * COUNT];
+        qreal score = INF_DISTANCE;
+        for (size_t i = 0; i < landmarks.size(); ++i) {
+            if (from[i] == INF_DISTANCE && to[i] == INF_DISTANCE) continue;
+            score = std::min(score, (from[i] == INF_DISTANCE ? 0 : from[i]) + (to[i] == INF_DISTANCE ? 0 : to[i]));
+        }
+
+        if (score > bestScore) {
+            best = vertex;
+            bestScore = score;
+        }
+    }
+
+    return best;
+}
+
+// Forward and backward runs of every landmark from first on, in parallel
+void Landmarks::computeDistances(size_t first) {
+    if (first >= landmarks.size()) return;
+
+    parallel::forEach(2 * (landmarks.size() - first), [&](size_t task) {
+        size_t landmark = first + task / 2;
+        bool isBackward = task % 2;
+
+        PathTree<qreal> tree;
+        ShortestPath<FlatGraph<qreal>>::run(isBackward ? *reversed : *graph, landmarks[landmark], tree);
+
+        std::vector<qreal>& distances = isBackward ? toLandmark : fromLandmark;
+        for (size_t vertex = 0; vertex < tree.distance.size(); ++vertex) {
+            distances[vertex * COUNT + landmark] = tree.distance[vertex];
+        }
+    });
+}
+
+qreal Landmarks::lowerBound(int vertex, int target) const {
+    if (landmarks.empty()) return 0;
+
+    const qreal *fromVertex = &fromLandmark[size_t(vertex) * COUNT];
+    const qreal *fromTarget = &fromLandmark[size_t(target) * COUNT];
+    const qreal *toVertex = &toLandmark[size_t(vertex) * COUNT];
+    const qreal *toTarget = &toLandmark[size_t(target) * COUNT];
+    qreal bound = 0;
+
+    for (size_t i = 0; i < landmarks.size(); ++i) {
+        // d(L, t) <= d(L, v) + d(v, t): a landmark that reaches v but not t
+        // proves t unreachable from v
+        if (fromVertex[i] != INF_DISTANCE) {
+            if (fromTarget[i] == INF_DISTANCE) return INF_DISTANCE;
+            bound = std::max(bound, fromTarget[i] - fromVertex[i]);
+        }
+
+        // d(v, L) <= d(v, t) + d(t, L)
+        if (toTarget[i] != INF_DISTANCE) {
+            if (toVertex[i] == INF_DISTANCE) return INF_DISTANCE;
+            bound = std::max(bound, toVertex[i] - toTarget[i]);
+        }
+    }
+
+    return bound;
+}
+
+bool Landmarks::query(int fromId, int toId, Route &route, size_t &settled) const {
+    TRACE_SCOPE("Landmarks::query");
+    route = Route();
+    settled = 0;
+    if (!graph) return false;
+
+    const int source = graph->indexOf(fromId);
+    const int target = graph->indexOf(toId);
+    if (source < 0 || target < 0 || lowerBound(source, target) == INF_DISTANCE) return false;
+
+    QueryWorkspace<qreal>& workspace = QueryWorkspace<qreal>::local(graph->size());
+    workspace.reach(source, 0, -1, -1);
+    workspace.push(lowerBound(source, target), source);
+
+    while (!workspace.heap.empty()) {
+        auto [estimate, vertex] = workspace.pop();
+
+        // Bounds from landmarks are consistent, so a vertex is settled once
+        // its first entry comes off; later entries are stale
+        qreal distance = workspace.distance[vertex];
+        if (estimate > distance + lowerBound(vertex, target)) continue;
+        ++settled;
+        if (vertex == target) break;
+
+        graph->forEachOut(vertex, [&](int next, qreal weight, int edgeId) {
+            qreal candidate = distance + weight;
+            if (candidate >= workspace.distanceTo(next)) return;
+
+            qreal bound = lowerBound(next, target);
+            if (bound == INF_DISTANCE) return;
+
+            workspace.reach(next, candidate, vertex, edgeId);
+            workspace.push(candidate + bound, next);
+        });
+    }
+
+    if (!workspace.isReached(target)) return false;
+
+    for (int vertex = target; vertex != -1; vertex = workspace.parent[vertex]) {
+        route.vertexIds.push_back(graph->idAt(vertex));
+        route.distances.push_back(workspace.distance[vertex]);
+        if (workspace.parent[vertex] != -1) route.edgeIds.push_back(workspace.parentEdge[vertex]);
+    }
+    std::reverse(route.vertexIds.begin(), route.vertexIds.end());
+    std::reverse(route.edgeIds.begin(), route.edgeIds.end());
+    std::reverse(route.distances.begin(), route.distances.end());
+    route.length = workspace.distance[target];
+    return true;
+}
@@ -0,0 +1,59 @@
+#ifndef LANDMARKS_H
+#define LANDMARKS_H
+
+#include "shortestpath.h"
+#include "vertexorder.h"
+
+#include <memory>
+#include <vector>
+
+// Point-to-point queries by A* with landmark lower bounds (ALT). For every
+// landmark L, the triangle inequality bounds dist(v, t) from below by
+// d(L, t) - d(L, v) and by d(v, L) - d(t, L), whatever the vertex positions
+// are. Landmarks are picked farthest first and kept across rebuilds while
+// they still have edges, so a rebuild after an edit is mostly the parallel
+// distance runs.
+class Landmarks {
+
+public:
+    // Starts from the given landmarks where they still have edges. With a
+    // count of 0 only the graphs are built and queries are plain Dijkstra
+    // searches that stop at the target. The graphs are numbered in the given
+    // order of ids (see VertexOrder), or in snapshot order
+    void build(const GraphSnapshot &snapshot, const std::vector<int> &landmarkIds, size_t count = COUNT,
+               const std::vector<int> &order = {});
+
+    bool isEmpty() const { return landmarks.empty(); }
+    std::vector<int> getLandmarkIds() const;
+    int getVersion() const { return version; }
+    const FlatGraph<qreal>& getGraph() const { return *graph; }
+    // Both numbered alike, so KShortestPaths can share them
+    std::shared_ptr<const FlatGraph<qreal>> sharedGraph() const { return graph; }
+    std::shared_ptr<const FlatGraph<qreal>> sharedReversed() const { return reversed; }
+    size_t memoryUsage() const;
+
+    // Shortest route from fromId to toId, false when there is none.
+    // settled counts the vertices taken off the queue
+    bool query(int fromId, int toId, Route &route, size_t &settled) const;
+
+    static constexpr size_t COUNT = 8;
+    // Landmark graphs serve many queries per version, so callers renumber
+    // them in this order
+    static constexpr VertexOrder::Method ORDER = VertexOrder::CUTHILL_MCKEE;
+
+private:
+    int farthest() const;
+    void computeDistances(size_t first);
+    qreal lowerBound(int vertex, int target) const;
+
+    std::shared_ptr<const FlatGraph<qreal>> graph;
+    std::shared_ptr<const FlatGraph<qreal>> reversed;
+    std::vector<int> landmarks;
+
+    // COUNT entries per vertex, so one bound reads one block
+    std::vector<qreal> fromLandmark;
+    std::vector<qreal> toLandmark;
+    int version = -1;
+};
+
+#endif // LANDMARKS_H
@@ -0,0 +1,117 @@
+#include "localsocket.h"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static bool toAddress(const std::string &path, sockaddr_un &address, std::string &error) {
+    address = {};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        error = "Socket path is too long";
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+int LocalSocket::listen(const std::string &path, std::string &error) {
+    sockaddr_un address;
+    if (!toAddress(path, address, error)) return -1;
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        error = std::strerror(errno);
+        return -1;
+    }
+
+    // A socket file left by an earlier run would make bind fail
+    ::unlink(path.c_str());
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || ::listen(fd, SOMAXCONN) < 0) {
+        error = std::strerror(errno);
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int LocalSocket::connect(const std::string &path, std::string &error) {
+    sockaddr_un address;
+    if (!toAddress(path, address, error)) return -1;
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        error = std::strerror(errno);
+        if (fd >= 0) ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int LocalSocket::accept(int listenFd, int timeoutMs) {
+    pollfd descriptor = {listenFd, POLLIN, 0};
+    if (::poll(&descriptor, 1, timeoutMs) <= 0) return -1;
+    return ::accept(listenFd, nullptr, nullptr);
+}
+
+bool LocalSocket::readFully(int fd, void *data, size_t size) {
+    char *bytes = static_cast<char*>(data);
+    while (size > 0) {
+        ssize_t count = ::recv(fd, bytes, size, 0);
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) return false;
+        bytes += count;
+        size -= count;
+    }
+    return true;
+}
+
+bool LocalSocket::writeFully(int fd, const void *data, size_t size) {
+    const char *bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        // A client that went away must not kill the editor with SIGPIPE
+        ssize_t count = ::send(fd, bytes, size, MSG_NOSIGNAL);
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) return false;
+        bytes += count;
+        size -= count;
+    }
+    return true;
+}
+
+void LocalSocket::shutdown(int fd) {
+    if (fd >= 0) ::shutdown(fd, SHUT_RDWR);
+}
+
+void LocalSocket::close(int fd) {
+    if (fd >= 0) ::close(fd);
+}
+
+void LocalSocket::remove(const std::string &path) {
+    ::unlink(path.c_str());
+}
+
+#else
+
+int LocalSocket::listen(const std::string &, std::string &error) {
+    error = "Unix domain sockets are not supported on this platform";
+    return -1;
+}
+
+int LocalSocket::connect(const std::string &, std::string &error) {
+    error = "Unix domain sockets are not supported on this platform";
+    return -1;
+}
+
+int LocalSocket::accept(int, int) { return -1; }
+bool LocalSocket::readFully(int, void *, size_t) { return false; }
+bool LocalSocket::writeFully(int, const void *, size_t) { return false; }
+void LocalSocket::shutdown(int) {}
+void LocalSocket::close(int) {}
+void LocalSocket::remove(const std::string &) {}
+
+#endif
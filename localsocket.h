@@ -0,0 +1,27 @@
+#ifndef LOCALSOCKET_H
+#define LOCALSOCKET_H
+
+#include <string>
+
+// Blocking Unix domain stream sockets for the query server and its client.
+// Functions return -1 or false on failure; on platforms without Unix domain
+// sockets every call fails.
+class LocalSocket {
+
+public:
+    static int listen(const std::string &path, std::string &error);
+    static int connect(const std::string &path, std::string &error);
+
+    // -1 when nothing arrived within timeoutMs
+    static int accept(int listenFd, int timeoutMs);
+
+    static bool readFully(int fd, void *data, size_t size);
+    static bool writeFully(int fd, const void *data, size_t size);
+
+    // Wakes a thread blocked reading fd
+    static void shutdown(int fd);
+    static void close(int fd);
+    static void remove(const std::string &path);
+};
+
+#endif // LOCALSOCKET_H
@@ -1,15 +1,54 @@
-#include "canvas.h"
-#include <QApplication>
-
-int main(int argc, char *argv[]) {
-    QApplication a(argc, argv);
-
-    Canvas canvas;
-    canvas.setWindowTitle("Graphs");
-    canvas.setMinimumHeight(600);
-    canvas.setMinimumWidth(800);
-    canvas.setStyleSheet("background-color: white");
-    canvas.show();
-
-    return a.exec();
-}
+#include "canvas.h"
+#include "benchmark.h"
+#include "queryclient.h"
+#include <QApplication>
+
+#include <cstdlib>
+#include <cstring>
+
+int main(int argc, char *argv[]) {
+    if (argc > 1 && std::strcmp(argv[1], "--bench-paths") == 0) {
+        return Benchmark::runPaths();
+    }
+
+    if (argc > 2 && std::strcmp(argv[1], "--query-client") == 0) {
+        int sourceId = argc > 3 ? std::atoi(argv[3]) : 0;
+        int count = argc > 4 ? std::atoi(argv[4]) : QueryClient::DEFAULT_COUNT;
+        return QueryClient::run(argv[2], sourceId, count);
+    }
+
+    bool isBenchmark = argc > 1 && std::strcmp(argv[1], "--bench") == 0;
+    if (isBenchmark) {
+        // Render without a display server
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication a(argc, argv);
+
+    if (isBenchmark) {
+        return Benchmark::run();
+    }
+
+    Canvas canvas;
+    canvas.setWindowTitle("Graphs");
+    canvas.setMinimumHeight(600);
+    canvas.setMinimumWidth(800);
+    canvas.setStyleSheet("background-color: white");
+    canvas.show();
+
+    // The server publishes every later edit, so it can start before loading
+    for (int i = 1; i + 1 < argc; i += 2) {
+        QString value = QString::fromLocal8Bit(argv[i + 1]);
+        if (std::strcmp(argv[i], "--serve") == 0) {
+            canvas.startServer(value);
+        }
+        else if (std::strcmp(argv[i], "--open") == 0) {
+            canvas.openGraph(value);
+        }
+        else if (std::strcmp(argv[i], "--generate") == 0) {
+            canvas.generateGraph(value);
+        }
+    }
+
+    return a.exec();
+}
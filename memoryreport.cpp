@@ -0,0 +1,73 @@
+#include "memoryreport.h"
+
+#include <QFile>
+#include <QTextStream>
+
+void MemoryReport::add(const QString &name, size_t count, size_t bytes) {
+    entries.push_back({name, count, bytes});
+}
+
+size_t MemoryReport::total() const {
+    size_t bytes = 0;
+    for (const Entry& entry : entries) {
+        bytes += entry.bytes;
+    }
+    return bytes;
+}
+
+size_t MemoryReport::heapBytes(size_t size) {
+    if (size == 0) return 0;
+    return (size + ALLOCATION_HEADER + ALLOCATION_ALIGNMENT - 1) / ALLOCATION_ALIGNMENT * ALLOCATION_ALIGNMENT;
+}
+
+size_t MemoryReport::stringBytes(const QString &string) {
+    // Empty strings share a static header; copies share the data, so a
+    // string is counted once per owner
+    if (string.isEmpty()) return 0;
+    return heapBytes(STRING_HEADER + (string.capacity() + 1) * sizeof(QChar));
+}
+
+QString MemoryReport::formatBytes(size_t bytes) {
+    if (bytes < 1024) return QString::number(bytes) + " B";
+    if (bytes < 1024 * 1024) return QString::number(bytes / 1024.0, 'f', 1) + " KB";
+    return QString::number(bytes / (1024.0 * 1024.0), 'f', 1) + " MB";
+}
+
+bool MemoryReport::save(const QString &path) const {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) return false;
+
+    QTextStream out(&file);
+    out << "category,count,bytes\n";
+    for (const Entry& entry : entries) {
+        out << entry.name << "," << entry.count << "," << entry.bytes << "\n";
+    }
+    out << "Total,," << total() << "\n";
+    return true;
+}
+
+void MemoryReport::draw(QPainter& painter, int x, int y) const {
+    const int textPaddingX = 6;
+    const int rectOffsetY = 14;
+
+    QStringList lines;
+    for (const Entry& entry : entries) {
+        lines.append(entry.name + ": " + formatBytes(entry.bytes) + " (" + QString::number(entry.count) + ")");
+    }
+    lines.append("Total: " + formatBytes(total()));
+
+    painter.save();
+    painter.resetTransform();
+    painter.setOpacity(1);
+    painter.setPen(Qt::black);
+
+    for (const QString& line : lines) {
+        y += LINE_HEIGHT;
+
+        int textWidth = painter.fontMetrics().horizontalAdvance(line);
+        painter.fillRect(QRect(x - textPaddingX / 2, y - rectOffsetY, textWidth + textPaddingX, LINE_HEIGHT), Qt::white);
+        painter.drawText(x, y, line);
+    }
+
+    painter.restore();
+}
@@ -0,0 +1,56 @@
+#ifndef MEMORYREPORT_H
+#define MEMORYREPORT_H
+
+#include <vector>
+
+#include <QPainter>
+#include <QString>
+
+// Estimated heap use per category. Sizes come from element counts and
+// capacities, with every allocation rounded like a typical malloc; memory
+// owned by Qt internals (fonts, glyph layouts) is not visible and not counted.
+class MemoryReport {
+
+public:
+    struct Entry {
+        QString name;
+        size_t count;
+        size_t bytes;
+    };
+
+    void add(const QString &name, size_t count, size_t bytes);
+    const std::vector<Entry>& getEntries() const { return entries; }
+    size_t total() const;
+
+    bool save(const QString &path) const;
+    void draw(QPainter &painter, int x, int y) const;
+    int panelHeight() const { return (entries.size() + 1) * LINE_HEIGHT; }
+
+    static size_t heapBytes(size_t size);
+    static size_t stringBytes(const QString &string);
+
+    template <typename T>
+    static size_t vectorBytes(const std::vector<T> &vector) {
+        return vector.capacity() ? heapBytes(vector.capacity() * sizeof(T)) : 0;
+    }
+
+    // Bucket array plus one node per element holding the next pointer,
+    // the cached hash and the value
+    template <typename Map>
+    static size_t hashBytes(const Map &map) {
+        size_t node = sizeof(void*) + sizeof(size_t) + sizeof(typename Map::value_type);
+        return heapBytes(map.bucket_count() * sizeof(void*)) + map.size() * heapBytes(node);
+    }
+
+    static QString formatBytes(size_t bytes);
+
+    static constexpr size_t ALLOCATION_HEADER = 8;
+    static constexpr size_t ALLOCATION_ALIGNMENT = 16;
+    static constexpr size_t STRING_HEADER = 24;
+    static constexpr int LINE_HEIGHT = 18;
+
+private:
+    std::vector<Entry> entries;
+};
+
+#endif // MEMORYREPORT_H
@@ -0,0 +1,131 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace parallel {
+    inline size_t threadCount() {
+        size_t count = std::thread::hardware_concurrency();
+        return count ? count : 1;
+    }
+
+    // Worker threads started once and shared by every forEach call. The
+    // calling thread works on its own job as well, so nested calls and calls
+    // from several threads at once always make progress.
+    class ThreadPool {
+
+    public:
+        static ThreadPool& instance() {
+            static ThreadPool pool(threadCount() - 1);
+            return pool;
+        }
+
+        ~ThreadPool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                isStopping = true;
+            }
+            wake.notify_all();
+
+            for (std::thread& worker : workers) {
+                worker.join();
+            }
+        }
+
+        void forEach(size_t count, const std::function<void(size_t)>& function) {
+            Job job;
+            job.count = count;
+            job.function = &function;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                jobs.push_back(&job);
+            }
+            wake.notify_all();
+
+            work(job);
+
+            std::unique_lock<std::mutex> lock(mutex);
+            jobs.erase(std::remove(jobs.begin(), jobs.end(), &job), jobs.end());
+            finished.wait(lock, [&]() { return job.done == job.count && job.helpers == 0; });
+        }
+
+    private:
+        struct Job {
+            size_t count;
+            const std::function<void(size_t)> *function;
+            std::atomic<size_t> next{0};
+            std::atomic<size_t> done{0};
+            int helpers = 0;
+        };
+
+        ThreadPool(size_t workerCount) {
+            for (size_t i = 0; i < workerCount; ++i) {
+                workers.emplace_back(&ThreadPool::workerLoop, this);
+            }
+        }
+
+        static void work(Job &job) {
+            for (size_t i = job.next++; i < job.count; i = job.next++) {
+                (*job.function)(i);
+                ++job.done;
+            }
+        }
+
+        void workerLoop() {
+            std::unique_lock<std::mutex> lock(mutex);
+
+            while (true) {
+                wake.wait(lock, [&]() { return isStopping || !jobs.empty(); });
+                if (isStopping) return;
+
+                Job *job = jobs.front();
+                if (job->next >= job->count) {
+                    jobs.pop_front();
+                    continue;
+                }
+
+                ++job->helpers;
+                lock.unlock();
+                work(*job);
+                lock.lock();
+                --job->helpers;
+
+                jobs.erase(std::remove(jobs.begin(), jobs.end(), job), jobs.end());
+                finished.notify_all();
+            }
+        }
+
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable finished;
+        std::deque<Job*> jobs;
+        bool isStopping = false;
+    };
+
+    // Calls function(i) for every i in [0, count) on all cores. Tasks are
+    // handed out one at a time, so uneven tasks still balance.
+    template <typename Function>
+    void forEach(size_t count, const Function& function) {
+        if (count == 0) return;
+
+        if (count == 1 || threadCount() == 1) {
+            for (size_t i = 0; i < count; ++i) {
+                function(i);
+            }
+            return;
+        }
+
+        ThreadPool::instance().forEach(count, [&](size_t i) { function(i); });
+    }
+}
+
+#endif // PARALLEL_H
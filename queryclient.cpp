@@ -0,0 +1,173 @@
+#include "queryclient.h"
+#include "localsocket.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+bool QueryClient::send(int fd, uint32_t requestId, QueryProtocol::Type type, const QueryProtocol::Writer &payload) {
+    QueryProtocol::Writer request;
+    request.put(requestId);
+    request.put(uint8_t(type));
+    request.append(payload);
+
+    std::string frame = request.frame();
+    return LocalSocket::writeFully(fd, frame.data(), frame.size());
+}
+
+bool QueryClient::receive(int fd, Response &response) {
+    uint32_t size;
+    if (!LocalSocket::readFully(fd, &size, sizeof(size))) return false;
+    if (size < QueryProtocol::RESPONSE_HEADER || size > QueryProtocol::MAX_FRAME) return false;
+
+    std::string frame(size, '\0');
+    if (!LocalSocket::readFully(fd, &frame[0], size)) return false;
+
+    QueryProtocol::Reader reader(frame);
+    reader.get(response.requestId);
+    reader.get(response.status);
+    reader.get(response.micros);
+    response.payload = frame.substr(QueryProtocol::RESPONSE_HEADER);
+    return true;
+}
+
+static bool isSameDistance(double first, double second) {
+    return first == second || std::abs(first - second) <= 1e-9 * std::max(std::abs(first), std::abs(second));
+}
+
+int QueryClient::run(const std::string &path, int sourceId, int count) {
+    std::string error;
+    int fd = LocalSocket::connect(path, error);
+    if (fd < 0) {
+        std::fprintf(stderr, "Could not connect to %s: %s\n", path.c_str(), error.c_str());
+        return 1;
+    }
+
+    auto fail = [&](const char *message) {
+        std::fprintf(stderr, "%s\n", message);
+        LocalSocket::close(fd);
+        return 1;
+    };
+
+    // Every distance from the source, the reference for the other answers
+    QueryProtocol::Writer single;
+    single.put(int32_t(sourceId));
+    Response response;
+    if (!send(fd, 0, QueryProtocol::SINGLE_SOURCE, single) || !receive(fd, response)) return fail("Connection lost");
+    if (response.status == QueryProtocol::TOO_LARGE) return fail("Too many reachable vertices for one response");
+    if (response.status != QueryProtocol::OK) return fail("Unknown source vertex");
+
+    QueryProtocol::Reader reader(response.payload);
+    uint32_t reachable = 0;
+    reader.get(reachable);
+    std::vector<int32_t> targets(reachable);
+    std::unordered_map<int32_t, double> expected;
+    for (int32_t& id : targets) {
+        double distance;
+        reader.get(id);
+        reader.get(distance);
+        expected[id] = distance;
+    }
+    std::printf("single-source: %u reachable vertices, %u us on the server\n", reachable, response.micros);
+
+    std::mt19937 random(SEED);
+    std::vector<int32_t> picked(count);
+    for (int32_t& id : picked) {
+        id = targets[random() % targets.size()];
+    }
+
+    QueryProtocol::Writer batch;
+    batch.put(uint32_t(count));
+    for (int32_t id : picked) {
+        batch.put(int32_t(sourceId));
+        batch.put(id);
+    }
+
+    // Pipelined up to the server's limit, answers are read once it is reached
+    using Clock = std::chrono::steady_clock;
+    std::vector<Clock::time_point> sent(count + 1);
+    int mismatches = 0;
+    std::vector<double> roundTrips;
+    double batchMicros = 0;
+    int requested = 0;
+    for (int answered = 0; answered <= count; ++answered) {
+        for (; requested <= count && size_t(requested - answered) < QueryProtocol::MAX_IN_FLIGHT; ++requested) {
+            sent[requested] = Clock::now();
+            if (requested == count) {
+                if (!send(fd, count + 1, QueryProtocol::BATCH, batch)) return fail("Connection lost");
+                continue;
+            }
+
+            QueryProtocol::Writer pair;
+            pair.put(int32_t(sourceId));
+            pair.put(picked[requested]);
+            if (!send(fd, requested + 1, QueryProtocol::POINT_TO_POINT, pair)) return fail("Connection lost");
+        }
+
+        if (!receive(fd, response)) return fail("Connection lost");
+        if (response.requestId < 1 || response.requestId > uint32_t(count) + 1) return fail("Unexpected request id");
+
+        size_t request = response.requestId - 1;
+        double micros = std::chrono::duration<double, std::micro>(Clock::now() - sent[request]).count();
+        QueryProtocol::Reader answer(response.payload);
+
+        if (response.status != QueryProtocol::OK) {
+            ++mismatches;
+        }
+        else if (request == size_t(count)) {
+            batchMicros = micros;
+            for (int i = 0; i < count; ++i) {
+                double distance = 0;
+                answer.get(distance);
+                if (!isSameDistance(distance, expected[picked[i]])) ++mismatches;
+            }
+        }
+        else {
+            roundTrips.push_back(micros);
+            double distance = 0;
+            uint32_t length = 0;
+            answer.get(distance);
+            answer.get(length);
+
+            std::vector<int32_t> route(length);
+            for (int32_t& id : route) {
+                answer.get(id);
+            }
+            bool isValid = length > 0 && route.front() == sourceId && route.back() == picked[request];
+            if (!isValid || !isSameDistance(distance, expected[picked[request]])) ++mismatches;
+        }
+    }
+
+    std::sort(roundTrips.begin(), roundTrips.end());
+    if (!roundTrips.empty()) {
+        std::printf("point-to-point: %d requests, round trip p50 %.0f us, p99 %.0f us\n", count,
+                    roundTrips[(roundTrips.size() - 1) / 2], roundTrips[(roundTrips.size() - 1) * 99 / 100]);
+    }
+    std::printf("batch: %d pairs in %.0f us\n", count, batchMicros);
+
+    QueryProtocol::Writer none;
+    if (!send(fd, count + 2, QueryProtocol::METRICS, none) || !receive(fd, response)) return fail("Connection lost");
+
+    const char *names[] = {"single-source", "point-to-point", "batch"};
+    QueryProtocol::Reader metrics(response.payload);
+    uint32_t types = 0;
+    metrics.get(types);
+    for (uint32_t type = 0; type < types && type < 3; ++type) {
+        uint64_t served = 0;
+        uint32_t p50 = 0, p99 = 0, max = 0;
+        metrics.get(served);
+        metrics.get(p50);
+        metrics.get(p99);
+        metrics.get(max);
+        std::printf("server %s: %llu requests, p50 %u us, p99 %u us, max %u us\n", names[type],
+                    (unsigned long long)served, p50, p99, max);
+    }
+
+    std::printf("mismatches: %d\n", mismatches);
+    LocalSocket::close(fd);
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,34 @@
+#ifndef QUERYCLIENT_H
+#define QUERYCLIENT_H
+
+#include "queryprotocol.h"
+
+#include <cstdint>
+#include <string>
+
+// Local harness for the query server, started with
+// "--query-client <socket> [sourceId] [count]". Asks for every distance
+// from the source, pipelines count point-to-point requests and one batch to
+// reachable targets, checks the answers against the single-source result
+// and prints round-trip and server latencies. Returns non-zero on any error.
+class QueryClient {
+
+public:
+    static int run(const std::string &path, int sourceId, int count);
+
+    static constexpr int SEED = 7;
+    static constexpr int DEFAULT_COUNT = 1000;
+
+private:
+    struct Response {
+        uint32_t requestId;
+        uint8_t status;
+        uint32_t micros;
+        std::string payload;
+    };
+
+    static bool send(int fd, uint32_t requestId, QueryProtocol::Type type, const QueryProtocol::Writer &payload);
+    static bool receive(int fd, Response &response);
+};
+
+#endif // QUERYCLIENT_H
@@ -0,0 +1,97 @@
+#ifndef QUERYPROTOCOL_H
+#define QUERYPROTOCOL_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Frames of the query server, in host byte order (the socket never leaves
+// the machine). Every frame starts with its size, not counting the size
+// field itself.
+//
+// Request:  u32 size, u32 requestId, u8 type, payload
+//   SINGLE_SOURCE   i32 sourceId
+//   POINT_TO_POINT  i32 fromId, i32 toId
+//   BATCH           u32 count, count x (i32 fromId, i32 toId)
+//   METRICS         -
+//
+// Response: u32 size, u32 requestId, u8 status, u32 latency in microseconds
+//           from the request being read to the response being ready, payload
+//   SINGLE_SOURCE   u32 count, count x (i32 id, f64 distance), reachable only
+//   POINT_TO_POINT  f64 distance (inf when unreachable), u32 count, count x i32 id
+//   BATCH           count x f64 distance, NaN for an unknown id
+//   METRICS         u32 types, per type (u64 count, u32 p50, u32 p99, u32 max)
+//
+// Requests are pipelined and responses can arrive in any order. The server
+// stops reading a connection with MAX_IN_FLIGHT unanswered requests, so a
+// client sending more must read responses meanwhile. A response that would
+// exceed MAX_FRAME is sent empty with status TOO_LARGE.
+class QueryProtocol {
+
+public:
+    enum Type : uint8_t {
+        SINGLE_SOURCE = 1,
+        POINT_TO_POINT = 2,
+        BATCH = 3,
+        METRICS = 4
+    };
+
+    enum Status : uint8_t {
+        OK = 0,
+        UNKNOWN_VERTEX = 1,
+        BAD_REQUEST = 2,
+        TOO_LARGE = 3
+    };
+
+    static constexpr int TYPE_COUNT = 3;
+    static constexpr size_t REQUEST_HEADER = 5;
+    static constexpr size_t RESPONSE_HEADER = 9;
+    static constexpr uint32_t MAX_FRAME = 1 << 26;
+    static constexpr size_t MAX_IN_FLIGHT = 256;
+
+    class Writer {
+
+    public:
+        template <typename T>
+        void put(T value) {
+            size_t at = data.size();
+            data.resize(at + sizeof(T));
+            std::memcpy(&data[at], &value, sizeof(T));
+        }
+
+        void append(const Writer &other) { data += other.data; }
+        size_t size() const { return data.size(); }
+
+        // Prepends the size field once the frame is complete
+        std::string frame() const {
+            Writer framed;
+            framed.put(uint32_t(data.size()));
+            return framed.data + data;
+        }
+
+    private:
+        std::string data;
+    };
+
+    class Reader {
+
+    public:
+        Reader(const std::string &data) : data(data) {}
+
+        template <typename T>
+        bool get(T &value) {
+            if (data.size() - at < sizeof(T)) return false;
+            std::memcpy(&value, &data[at], sizeof(T));
+            at += sizeof(T);
+            return true;
+        }
+
+        size_t remaining() const { return data.size() - at; }
+
+    private:
+        const std::string &data;
+        size_t at = 0;
+    };
+};
+
+#endif // QUERYPROTOCOL_H
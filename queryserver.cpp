@@ -0,0 +1,429 @@
+#include "queryserver.h"
+#include "localsocket.h"
+#include "parallel.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+QueryServer::Connection::~Connection() {
+    LocalSocket::close(fd);
+}
+
+QueryServer::~QueryServer() {
+    stop();
+}
+
+bool QueryServer::start(const std::string &socketPath, std::string &error) {
+    stop();
+
+    listenFd = LocalSocket::listen(socketPath, error);
+    if (listenFd < 0) return false;
+
+    path = socketPath;
+    stopRequested = false;
+    running = true;
+    acceptor = std::thread(&QueryServer::acceptLoop, this);
+    for (size_t i = 0; i < parallel::threadCount(); ++i) {
+        workers.emplace_back(&QueryServer::workLoop, this);
+    }
+    builder = std::thread(&QueryServer::buildLoop, this);
+    return true;
+}
+
+void QueryServer::stop() {
+    if (!running) return;
+
+    stopRequested = true;
+    {
+        // Taking the lock orders the flag before any waiter's next check
+        std::lock_guard<std::mutex> lock(queueMutex);
+    }
+    {
+        std::lock_guard<std::mutex> lock(graphMutex);
+    }
+    queued.notify_all();
+    space.notify_all();
+    indexWanted.notify_all();
+
+    acceptor.join();
+    builder.join();
+    LocalSocket::close(listenFd);
+    listenFd = -1;
+
+    std::lock_guard<std::mutex> lock(readersMutex);
+    for (Reader& reader : readers) {
+        auto connection = reader.connection.lock();
+        if (!connection) continue;
+        {
+            std::lock_guard<std::mutex> waiting(connection->mutex);
+        }
+        connection->changed.notify_all();
+        LocalSocket::shutdown(connection->fd);
+    }
+    for (Reader& reader : readers) {
+        reader.thread.join();
+    }
+    readers.clear();
+
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+    jobs.clear();
+
+    LocalSocket::remove(path);
+    running = false;
+}
+
+void QueryServer::setGraph(std::shared_ptr<const GraphSnapshot> graph) {
+    std::lock_guard<std::mutex> lock(graphMutex);
+    snapshot = std::move(graph);
+}
+
+void QueryServer::acceptLoop() {
+    while (!stopRequested) {
+        int fd = LocalSocket::accept(listenFd, ACCEPT_POLL_MS);
+        if (fd < 0) continue;
+
+        auto connection = std::make_shared<Connection>();
+        connection->fd = fd;
+
+        std::lock_guard<std::mutex> lock(readersMutex);
+        // Readers of closed connections have finished, so joining is immediate
+        for (Reader& reader : readers) {
+            auto previous = reader.connection.lock();
+            if (!previous || previous->isClosed) reader.thread.join();
+        }
+        readers.erase(std::remove_if(readers.begin(), readers.end(), [](const Reader &reader) {
+            return !reader.thread.joinable();
+        }), readers.end());
+
+        readers.push_back({connection, std::thread(&QueryServer::readLoop, this, connection)});
+    }
+}
+
+void QueryServer::readLoop(std::shared_ptr<Connection> connection) {
+    std::thread writer(&QueryServer::writeLoop, this, connection);
+
+    while (!stopRequested) {
+        {
+            // Nothing more is read while the client lets its answers pile up
+            std::unique_lock<std::mutex> lock(connection->mutex);
+            connection->changed.wait(lock, [&]() {
+                return connection->unanswered < QueryProtocol::MAX_IN_FLIGHT || connection->isBroken || stopRequested;
+            });
+            if (connection->isBroken) break;
+        }
+
+        uint32_t size;
+        if (!LocalSocket::readFully(connection->fd, &size, sizeof(size))) break;
+
+        // The stream cannot be resynchronised after a bad size, so the connection ends
+        if (size < QueryProtocol::REQUEST_HEADER || size > QueryProtocol::MAX_FRAME) break;
+
+        std::string frame(size, '\0');
+        if (!LocalSocket::readFully(connection->fd, &frame[0], size)) break;
+
+        Job job;
+        QueryProtocol::Reader reader(frame);
+        reader.get(job.requestId);
+        reader.get(job.type);
+        job.payload = frame.substr(QueryProtocol::REQUEST_HEADER);
+        job.connection = connection;
+        job.received = std::chrono::steady_clock::now();
+        {
+            std::lock_guard<std::mutex> lock(connection->mutex);
+            ++connection->unanswered;
+        }
+
+        std::unique_lock<std::mutex> lock(queueMutex);
+        space.wait(lock, [&]() { return jobs.size() < MAX_QUEUED || stopRequested; });
+        if (stopRequested) break;
+
+        jobs.push_back(std::move(job));
+        queued.notify_one();
+    }
+
+    // The writer sends what is still being answered, then the connection ends
+    {
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        connection->isReading = false;
+    }
+    connection->changed.notify_all();
+    writer.join();
+
+    LocalSocket::shutdown(connection->fd);
+    connection->isClosed = true;
+}
+
+void QueryServer::writeLoop(std::shared_ptr<Connection> connection) {
+    while (true) {
+        std::string frame;
+        {
+            std::unique_lock<std::mutex> lock(connection->mutex);
+            connection->changed.wait(lock, [&]() {
+                return !connection->outbox.empty() || (!connection->isReading && !connection->unanswered) || stopRequested;
+            });
+            if (connection->outbox.empty() || stopRequested) return;
+
+            frame = std::move(connection->outbox.front());
+            connection->outbox.pop_front();
+        }
+
+        bool isSent = LocalSocket::writeFully(connection->fd, frame.data(), frame.size());
+        {
+            std::lock_guard<std::mutex> lock(connection->mutex);
+            --connection->unanswered;
+            connection->isBroken = !isSent;
+        }
+        connection->changed.notify_all();
+
+        if (!isSent) {
+            // Wakes the reader, the client is gone
+            LocalSocket::shutdown(connection->fd);
+            return;
+        }
+    }
+}
+
+void QueryServer::workLoop() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queued.wait(lock, [&]() { return !jobs.empty() || stopRequested; });
+            if (stopRequested) return;
+
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        space.notify_one();
+
+        answer(job);
+    }
+}
+
+// Builds landmarks when a request finds them out of date. Building happens
+// outside graphMutex so the editor never waits to publish, and edits made
+// meanwhile are picked up by the next request
+void QueryServer::buildLoop() {
+    while (true) {
+        std::shared_ptr<const GraphSnapshot> graph;
+        std::shared_ptr<const Index> built;
+        {
+            std::unique_lock<std::mutex> lock(graphMutex);
+            indexWanted.wait(lock, [&]() { return isIndexWanted || stopRequested; });
+            if (stopRequested) return;
+
+            isIndexWanted = false;
+            graph = snapshot;
+            built = index;
+        }
+        if (!graph || (built && built->version == graph->getVersion())) continue;
+
+        TRACE_SCOPE("QueryServer::buildIndex");
+        auto next = std::make_shared<Index>();
+        next->version = graph->getVersion();
+        next->landmarks.build(*graph, built ? built->landmarks.getLandmarkIds() : std::vector<int>(), Landmarks::COUNT,
+                              VertexOrder::compute(*graph, Landmarks::ORDER));
+
+        std::lock_guard<std::mutex> lock(graphMutex);
+        index = next;
+    }
+}
+
+// Landmarks of the latest snapshot, or null while they are being built
+std::shared_ptr<const QueryServer::Index> QueryServer::currentIndex() {
+    std::lock_guard<std::mutex> lock(graphMutex);
+    if (!snapshot) return nullptr;
+    if (index && index->version == snapshot->getVersion()) return index;
+
+    isIndexWanted = true;
+    indexWanted.notify_one();
+    return nullptr;
+}
+
+// Graphs of the latest snapshot without landmark tables, taken from the
+// landmarks when they are current. Queries on them are plain searches
+std::shared_ptr<const QueryServer::Index> QueryServer::currentPlain() {
+    std::shared_ptr<const GraphSnapshot> graph;
+    std::shared_ptr<const Index> built;
+    std::shared_ptr<const Index> alone;
+    auto load = [&]() {
+        std::lock_guard<std::mutex> lock(graphMutex);
+        graph = snapshot;
+        built = index;
+        alone = plain;
+    };
+
+    load();
+    if (!graph) return nullptr;
+    if (built && built->version == graph->getVersion()) return built;
+    if (alone && alone->version == graph->getVersion()) return alone;
+
+    std::lock_guard<std::mutex> building(plainMutex);
+    load();
+    if (!graph) return nullptr;
+    if (built && built->version == graph->getVersion()) return built;
+    if (alone && alone->version == graph->getVersion()) return alone;
+
+    TRACE_SCOPE("QueryServer::buildPlain");
+    auto next = std::make_shared<Index>();
+    next->version = graph->getVersion();
+    next->landmarks.build(*graph, {}, 0, VertexOrder::compute(*graph, Landmarks::ORDER));
+
+    std::lock_guard<std::mutex> lock(graphMutex);
+    plain = next;
+    return next;
+}
+
+void QueryServer::answer(const Job &job) {
+    TRACE_SCOPE("QueryServer::answer");
+    const double INF_DISTANCE = std::numeric_limits<double>::infinity();
+    QueryProtocol::Reader request(job.payload);
+    QueryProtocol::Writer payload;
+    uint8_t status = QueryProtocol::OK;
+
+    std::shared_ptr<const Index> current;
+    std::shared_ptr<const FlatGraph<qreal>> graph;
+    if (job.type != QueryProtocol::METRICS) {
+        if (job.type != QueryProtocol::SINGLE_SOURCE) current = currentIndex();
+        if (!current) current = currentPlain();
+        if (current) graph = current->landmarks.sharedGraph();
+    }
+    auto indexOf = [&](int32_t id) { return graph ? graph->indexOf(id) : -1; };
+
+    if (job.type == QueryProtocol::SINGLE_SOURCE) {
+        int32_t sourceId;
+        if (!request.get(sourceId) || request.remaining()) {
+            status = QueryProtocol::BAD_REQUEST;
+        }
+        else if (indexOf(sourceId) < 0) {
+            status = QueryProtocol::UNKNOWN_VERTEX;
+        }
+        else {
+            QueryWorkspace<qreal>& tree = ShortestPath<FlatGraph<qreal>>::run(*graph, indexOf(sourceId));
+
+            payload.put(uint32_t(tree.order.size()));
+            for (int vertex : tree.order) {
+                payload.put(int32_t(graph->idAt(vertex)));
+                payload.put(double(tree.distance[vertex]));
+            }
+        }
+    }
+    else if (job.type == QueryProtocol::POINT_TO_POINT) {
+        int32_t fromId, toId;
+        if (!request.get(fromId) || !request.get(toId) || request.remaining()) {
+            status = QueryProtocol::BAD_REQUEST;
+        }
+        else if (indexOf(fromId) < 0 || indexOf(toId) < 0) {
+            status = QueryProtocol::UNKNOWN_VERTEX;
+        }
+        else {
+            Route route;
+            size_t settled;
+            bool isFound = current->landmarks.query(fromId, toId, route, settled);
+
+            payload.put(isFound ? double(route.length) : INF_DISTANCE);
+            payload.put(uint32_t(route.vertexIds.size()));
+            for (int id : route.vertexIds) {
+                payload.put(int32_t(id));
+            }
+        }
+    }
+    else if (job.type == QueryProtocol::BATCH) {
+        uint32_t count;
+        if (!request.get(count) || request.remaining() != size_t(count) * 2 * sizeof(int32_t)) {
+            status = QueryProtocol::BAD_REQUEST;
+        }
+        else {
+            std::vector<int32_t> pairs(2 * size_t(count));
+            for (int32_t& id : pairs) {
+                request.get(id);
+            }
+
+            // Queries are independent, so the whole pool helps with one batch
+            std::vector<double> distances(count);
+            parallel::forEach(count, [&](size_t i) {
+                int32_t fromId = pairs[2 * i];
+                int32_t toId = pairs[2 * i + 1];
+                if (indexOf(fromId) < 0 || indexOf(toId) < 0) {
+                    distances[i] = std::nan("");
+                    return;
+                }
+
+                Route route;
+                size_t settled;
+                distances[i] = current->landmarks.query(fromId, toId, route, settled) ? route.length : INF_DISTANCE;
+            });
+
+            for (double distance : distances) {
+                payload.put(distance);
+            }
+        }
+    }
+    else if (job.type == QueryProtocol::METRICS) {
+        std::array<Latency, QueryProtocol::TYPE_COUNT> all = latencies();
+        payload.put(uint32_t(all.size()));
+        for (const Latency& latency : all) {
+            payload.put(latency.count);
+            payload.put(latency.p50);
+            payload.put(latency.p99);
+            payload.put(latency.max);
+        }
+    }
+    else {
+        status = QueryProtocol::BAD_REQUEST;
+    }
+
+    // The client refuses larger frames, so the answer is replaced by an error
+    if (QueryProtocol::RESPONSE_HEADER + payload.size() > QueryProtocol::MAX_FRAME) {
+        status = QueryProtocol::TOO_LARGE;
+        payload = QueryProtocol::Writer();
+    }
+
+    auto elapsed = std::chrono::steady_clock::now() - job.received;
+    uint32_t micros = std::min<int64_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count(), UINT32_MAX);
+    if (job.type != QueryProtocol::METRICS) record(job.type, micros);
+
+    QueryProtocol::Writer response;
+    response.put(job.requestId);
+    response.put(status);
+    response.put(micros);
+    response.append(payload);
+
+    {
+        std::lock_guard<std::mutex> lock(job.connection->mutex);
+        job.connection->outbox.push_back(response.frame());
+    }
+    job.connection->changed.notify_all();
+}
+
+void QueryServer::record(uint8_t type, uint32_t micros) {
+    if (type < QueryProtocol::SINGLE_SOURCE || type > QueryProtocol::BATCH) return;
+
+    std::lock_guard<std::mutex> lock(metricsMutex);
+    History& history = histories[type - QueryProtocol::SINGLE_SOURCE];
+    if (history.samples.size() < LATENCY_HISTORY) history.samples.push_back(micros);
+    else history.samples[history.count % LATENCY_HISTORY] = micros;
+    ++history.count;
+}
+
+std::array<QueryServer::Latency, QueryProtocol::TYPE_COUNT> QueryServer::latencies() {
+    std::array<Latency, QueryProtocol::TYPE_COUNT> result = {};
+    std::lock_guard<std::mutex> lock(metricsMutex);
+
+    for (size_t type = 0; type < histories.size(); ++type) {
+        std::vector<uint32_t> sorted = histories[type].samples;
+        std::sort(sorted.begin(), sorted.end());
+
+        result[type].count = histories[type].count;
+        if (sorted.empty()) continue;
+        result[type].p50 = sorted[(sorted.size() - 1) / 2];
+        result[type].p99 = sorted[(sorted.size() - 1) * 99 / 100];
+        result[type].max = sorted.back();
+    }
+    return result;
+}
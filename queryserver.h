@@ -0,0 +1,131 @@
+#ifndef QUERYSERVER_H
+#define QUERYSERVER_H
+
+#include "graphsnapshot.h"
+#include "landmarks.h"
+#include "queryprotocol.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Answers shortest-path requests from other processes over a Unix domain
+// socket (see QueryProtocol). One thread accepts, each connection has a
+// reader and a writer, and a pool of workers answers from the latest
+// published snapshot. The first point-to-point or batch request after a
+// change starts a landmark rebuild on a builder thread; until it is done
+// those requests run without landmarks on the plain graphs that
+// single-source requests use, so no worker waits for a build.
+class QueryServer {
+
+public:
+    struct Latency {
+        uint64_t count;
+        uint32_t p50;
+        uint32_t p99;
+        uint32_t max;
+    };
+
+    ~QueryServer();
+
+    bool start(const std::string &path, std::string &error);
+    void stop();
+    bool isRunning() const { return running; }
+
+    // Called by the editor whenever the graph changes
+    void setGraph(std::shared_ptr<const GraphSnapshot> graph);
+
+    // Per request type, over the last LATENCY_HISTORY requests
+    std::array<Latency, QueryProtocol::TYPE_COUNT> latencies();
+
+    // Readers wait while this many requests wait for a worker
+    static constexpr size_t MAX_QUEUED = 1024;
+    static constexpr size_t LATENCY_HISTORY = 4096;
+    static constexpr int ACCEPT_POLL_MS = 100;
+
+private:
+    // Workers queue responses for the connection's writer, so a client that
+    // stops reading holds up only its own reader, never the pool
+    struct Connection {
+        ~Connection();
+
+        int fd = -1;
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::deque<std::string> outbox;
+        size_t unanswered = 0;
+        bool isReading = true;
+        bool isBroken = false;
+        std::atomic<bool> isClosed{false};
+    };
+
+    // Weak, so a connection closes once its reader and queued jobs are done
+    struct Reader {
+        std::weak_ptr<Connection> connection;
+        std::thread thread;
+    };
+
+    struct Job {
+        std::shared_ptr<Connection> connection;
+        uint32_t requestId;
+        uint8_t type;
+        std::string payload;
+        std::chrono::steady_clock::time_point received;
+    };
+
+    struct Index {
+        int version;
+        Landmarks landmarks;
+    };
+
+    struct History {
+        uint64_t count = 0;
+        std::vector<uint32_t> samples;
+    };
+
+    void acceptLoop();
+    void readLoop(std::shared_ptr<Connection> connection);
+    void writeLoop(std::shared_ptr<Connection> connection);
+    void workLoop();
+    void buildLoop();
+    void answer(const Job &job);
+    std::shared_ptr<const Index> currentIndex();
+    std::shared_ptr<const Index> currentPlain();
+    void record(uint8_t type, uint32_t micros);
+
+    std::string path;
+    int listenFd = -1;
+    std::thread acceptor;
+    std::vector<std::thread> workers;
+    std::thread builder;
+    std::atomic<bool> running{false};
+    std::atomic<bool> stopRequested{false};
+
+    std::mutex readersMutex;
+    std::vector<Reader> readers;
+
+    std::mutex queueMutex;
+    std::condition_variable queued;
+    std::condition_variable space;
+    std::deque<Job> jobs;
+
+    std::mutex graphMutex;
+    std::condition_variable indexWanted;
+    bool isIndexWanted = false;
+    std::mutex plainMutex;
+    std::shared_ptr<const GraphSnapshot> snapshot;
+    std::shared_ptr<const Index> index;
+    std::shared_ptr<const Index> plain;
+
+    std::mutex metricsMutex;
+    std::array<History, QueryProtocol::TYPE_COUNT> histories;
+};
+
+#endif // QUERYSERVER_H
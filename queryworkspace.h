@@ -0,0 +1,89 @@
+#ifndef QUERYWORKSPACE_H
+#define QUERYWORKSPACE_H
+
+#include "flatgraph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Scratch arrays for one search, kept per thread and reused by every query
+// on it. An entry only counts when it carries the current epoch, so starting
+// a query is O(1) instead of refilling arrays sized to the graph. A search
+// must finish before its thread starts another. Arrays left much larger than
+// the graph by an earlier one are released.
+template <typename Weight>
+struct QueryWorkspace {
+    typedef std::pair<Weight, int> Entry;
+
+    std::vector<Weight> distance;
+    std::vector<int> parent;
+    std::vector<int> parentEdge;
+    std::vector<uint32_t> reached;
+    std::vector<uint32_t> blocked;
+    std::vector<Entry> heap;
+    std::vector<int> order;
+    uint32_t epoch = 0;
+
+    // The calling thread's workspace, ready for a graph of size vertices
+    static QueryWorkspace& local(int size) {
+        static thread_local QueryWorkspace workspace;
+        workspace.begin(size);
+        return workspace;
+    }
+
+    void begin(int size) {
+        if (reached.size() < size_t(size) || reached.size() > std::max(SHRINK_FACTOR * size, KEPT_SIZE)) {
+            distance = std::vector<Weight>(size);
+            parent = std::vector<int>(size);
+            parentEdge = std::vector<int>(size);
+            reached = std::vector<uint32_t>(size, 0);
+            blocked = std::vector<uint32_t>(size, 0);
+            heap = std::vector<Entry>();
+            order = std::vector<int>();
+        }
+
+        if (++epoch == 0) {
+            std::fill(reached.begin(), reached.end(), 0);
+            std::fill(blocked.begin(), blocked.end(), 0);
+            epoch = 1;
+        }
+        heap.clear();
+        order.clear();
+    }
+
+    bool isReached(int vertex) const { return reached[vertex] == epoch; }
+    bool isBlocked(int vertex) const { return blocked[vertex] == epoch; }
+    void block(int vertex) { blocked[vertex] = epoch; }
+
+    Weight distanceTo(int vertex) const {
+        return isReached(vertex) ? distance[vertex] : WeightTraits<Weight>::infinity();
+    }
+
+    void reach(int vertex, Weight value, int parentVertex, int edgeId) {
+        reached[vertex] = epoch;
+        distance[vertex] = value;
+        parent[vertex] = parentVertex;
+        parentEdge[vertex] = edgeId;
+    }
+
+    // Min-heap on the key, stale entries are left for the caller to skip
+    void push(Weight key, int vertex) {
+        heap.push_back({key, vertex});
+        std::push_heap(heap.begin(), heap.end(), isLater);
+    }
+
+    Entry pop() {
+        std::pop_heap(heap.begin(), heap.end(), isLater);
+        Entry entry = heap.back();
+        heap.pop_back();
+        return entry;
+    }
+
+    static bool isLater(const Entry &first, const Entry &second) { return first.first > second.first; }
+
+    static constexpr size_t SHRINK_FACTOR = 4;
+    static constexpr size_t KEPT_SIZE = 1 << 16;
+};
+
+#endif // QUERYWORKSPACE_H
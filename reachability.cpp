@@ -0,0 +1,178 @@
+#include "reachability.h"
+#include "parallel.h"
+#include "trace.h"
+
+Reachability::Reachability(const GraphSnapshot &graph, const std::vector<int> &order) {
+    index.assign(graph.vertexIdBound(), -1);
+    ids.reserve(graph.vertexCount());
+    if (order.empty()) {
+        graph.forEachVertex([&](const VertexRecord &vertex) {
+            ids.push_back(vertex.id);
+        });
+    }
+    else {
+        ids = order;
+    }
+
+    for (size_t i = 0; i < ids.size(); ++i) {
+        index[ids[i]] = i;
+    }
+
+    outOffsets.assign(ids.size() + 1, 0);
+    inOffsets.assign(ids.size() + 1, 0);
+    for (size_t i = 0; i < ids.size(); ++i) {
+        const VertexRecord &vertex = *graph.vertex(ids[i]);
+        outOffsets[i + 1] = outOffsets[i] + vertex.out.vertexId.size();
+        inOffsets[i + 1] = inOffsets[i] + vertex.in.vertexId.size();
+    }
+
+    outTargets.resize(outOffsets.back());
+    inSources.resize(inOffsets.back());
+    for (size_t i = 0; i < ids.size(); ++i) {
+        const VertexRecord &vertex = *graph.vertex(ids[i]);
+        for (size_t j = 0; j < vertex.out.vertexId.size(); ++j) {
+            outTargets[outOffsets[i] + j] = index[vertex.out.vertexId[j]];
+        }
+        for (size_t j = 0; j < vertex.in.vertexId.size(); ++j) {
+            inSources[inOffsets[i] + j] = index[vertex.in.vertexId[j]];
+        }
+    }
+}
+
+// True if this call is the one that set the bit
+bool Reachability::mark(Bitmap &visited, int vertex) {
+    uint64_t bit = uint64_t(1) << (vertex & 63);
+    if (visited[vertex >> 6].load(std::memory_order_relaxed) & bit) return false;
+    return !(visited[vertex >> 6].fetch_or(bit, std::memory_order_relaxed) & bit);
+}
+
+void Reachability::topDown(const std::vector<int> &frontier, Bitmap &visited, std::vector<int> &next, size_t work) const {
+    size_t chunks = (frontier.size() + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    std::vector<std::vector<int>> found(chunks);
+
+    auto expand = [&](size_t chunk) {
+        size_t end = std::min(frontier.size(), (chunk + 1) * CHUNK_SIZE);
+        for (size_t i = chunk * CHUNK_SIZE; i < end; ++i) {
+            int vertex = frontier[i];
+            for (size_t j = outOffsets[vertex]; j < outOffsets[vertex + 1]; ++j) {
+                if (mark(visited, outTargets[j])) found[chunk].push_back(outTargets[j]);
+            }
+        }
+    };
+
+    if (work < PARALLEL_THRESHOLD) {
+        for (size_t chunk = 0; chunk < chunks; ++chunk) {
+            expand(chunk);
+        }
+    }
+    else {
+        parallel::forEach(chunks, expand);
+    }
+
+    for (const std::vector<int>& vertices : found) {
+        next.insert(next.end(), vertices.begin(), vertices.end());
+    }
+}
+
+void Reachability::bottomUp(const std::vector<int> &frontier, Bitmap &visited, std::vector<int> &next) const {
+    std::vector<uint64_t> inFrontier(visited.size(), 0);
+    for (int vertex : frontier) {
+        inFrontier[vertex >> 6] |= uint64_t(1) << (vertex & 63);
+    }
+
+    // Chunks cover whole bitmap words, so every word has a single writer
+    size_t chunks = (ids.size() + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    std::vector<std::vector<int>> found(chunks);
+
+    auto adopt = [&](size_t chunk) {
+        size_t end = std::min(ids.size(), (chunk + 1) * CHUNK_SIZE);
+        for (size_t vertex = chunk * CHUNK_SIZE; vertex < end; ++vertex) {
+            uint64_t bit = uint64_t(1) << (vertex & 63);
+            if (visited[vertex >> 6].load(std::memory_order_relaxed) & bit) continue;
+
+            for (size_t j = inOffsets[vertex]; j < inOffsets[vertex + 1]; ++j) {
+                int source = inSources[j];
+                if (!(inFrontier[source >> 6] & (uint64_t(1) << (source & 63)))) continue;
+
+                visited[vertex >> 6].fetch_or(bit, std::memory_order_relaxed);
+                found[chunk].push_back(vertex);
+                break;
+            }
+        }
+    };
+
+    if (ids.size() < PARALLEL_THRESHOLD) {
+        for (size_t chunk = 0; chunk < chunks; ++chunk) {
+            adopt(chunk);
+        }
+    }
+    else {
+        parallel::forEach(chunks, adopt);
+    }
+
+    for (const std::vector<int>& vertices : found) {
+        next.insert(next.end(), vertices.begin(), vertices.end());
+    }
+}
+
+std::vector<int> Reachability::firstFrom(const GraphSnapshot &graph, int startId, size_t limit) {
+    std::vector<int> result;
+    if (!graph.vertex(startId) || limit == 0) return result;
+
+    std::unordered_set<int> visited = {startId};
+    result.push_back(startId);
+    for (size_t i = 0; i < result.size() && result.size() < limit; ++i) {
+        for (int id : graph.vertex(result[i])->out.vertexId) {
+            if (!visited.insert(id).second) continue;
+
+            result.push_back(id);
+            if (result.size() == limit) break;
+        }
+    }
+    return result;
+}
+
+std::vector<int> Reachability::from(int startId) const {
+    TRACE_SCOPE("Reachability::from");
+    std::vector<int> result;
+    if (startId < 0 || size_t(startId) >= index.size() || index[startId] == -1) return result;
+
+    Bitmap visited((ids.size() + 63) / 64);
+    for (std::atomic<uint64_t>& word : visited) {
+        word.store(0, std::memory_order_relaxed);
+    }
+
+    int start = index[startId];
+    mark(visited, start);
+    std::vector<int> frontier = {start};
+    std::vector<int> next;
+
+    size_t frontierEdges = outOffsets[start + 1] - outOffsets[start];
+    size_t unexploredEdges = outTargets.size() - frontierEdges;
+    bool isBottomUp = false;
+
+    while (!frontier.empty()) {
+        if (!isBottomUp && frontierEdges > unexploredEdges / ALPHA) isBottomUp = true;
+        else if (isBottomUp && frontier.size() < ids.size() / BETA) isBottomUp = false;
+
+        next.clear();
+        if (isBottomUp) bottomUp(frontier, visited, next);
+        else topDown(frontier, visited, next, frontierEdges);
+
+        frontierEdges = 0;
+        for (int vertex : next) {
+            frontierEdges += outOffsets[vertex + 1] - outOffsets[vertex];
+        }
+        unexploredEdges -= std::min(unexploredEdges, frontierEdges);
+        frontier.swap(next);
+    }
+
+    for (size_t word = 0; word < visited.size(); ++word) {
+        uint64_t bits = visited[word].load(std::memory_order_relaxed);
+        for (int bit = 0; bits; ++bit, bits >>= 1) {
+            if (bits & 1) result.push_back(ids[word * 64 + bit]);
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,52 @@
+#ifndef REACHABILITY_H
+#define REACHABILITY_H
+
+#include "graphsnapshot.h"
+
+#include <atomic>
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+// Vertices reachable from a start vertex, found one BFS level at a time.
+// Each level either expands the frontier along out-edges (top-down) or lets
+// every unvisited vertex look for a parent in the frontier along its
+// in-edges (bottom-up), whichever is expected to touch fewer edges.
+// Vertices are numbered in snapshot order or in the given order of ids.
+class Reachability {
+
+public:
+    Reachability(const GraphSnapshot &graph, const std::vector<int> &order = {});
+
+    // Ids of the reachable vertices, the start vertex included
+    std::vector<int> from(int startId) const;
+
+    // At most limit reachable ids, found on the snapshot without building
+    // the index, for callers that only need to know whether a run is small
+    static std::vector<int> firstFrom(const GraphSnapshot &graph, int startId, size_t limit);
+
+    // Switch to bottom-up once the frontier has more than 1/ALPHA of the
+    // unexplored edges, back to top-down below 1/BETA of the vertices
+    static constexpr size_t ALPHA = 14;
+    static constexpr size_t BETA = 24;
+
+    // Levels with less work than this run on the calling thread
+    static constexpr size_t PARALLEL_THRESHOLD = 4096;
+    static constexpr size_t CHUNK_SIZE = 1024;
+
+private:
+    typedef std::vector<std::atomic<uint64_t>> Bitmap;
+
+    static bool mark(Bitmap &visited, int vertex);
+    void topDown(const std::vector<int> &frontier, Bitmap &visited, std::vector<int> &next, size_t work) const;
+    void bottomUp(const std::vector<int> &frontier, Bitmap &visited, std::vector<int> &next) const;
+
+    std::vector<int> ids;
+    std::vector<int> index;
+    std::vector<size_t> outOffsets;
+    std::vector<int> outTargets;
+    std::vector<size_t> inOffsets;
+    std::vector<int> inSources;
+};
+
+#endif // REACHABILITY_H
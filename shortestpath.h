@@ -0,0 +1,159 @@
+#ifndef SHORTESTPATH_H
+#define SHORTESTPATH_H
+
+#include "flatgraph.h"
+#include "queryworkspace.h"
+
+#include <functional>
+#include <queue>
+#include <vector>
+
+// Result of a single-source run, indexed like the graph it ran on
+template <typename Weight>
+struct PathTree {
+    std::vector<Weight> distance;
+    std::vector<int> parent;
+    std::vector<int> parentEdge;
+    std::vector<int> order;
+};
+
+// A path between two vertices by id, with the distance at every vertex
+struct Route {
+    std::vector<int> vertexIds;
+    std::vector<int> edgeIds;
+    std::vector<qreal> distances;
+    qreal length;
+};
+
+// Single-source shortest paths over any graph with size(), getMaxWeight()
+// and forEachOut(). Integer weights up to DIAL_MAX_WEIGHT use Dial's bucket
+// queue, which is only compiled for integer weight types; everything else
+// uses a binary heap.
+template <typename Graph>
+class ShortestPath {
+
+public:
+    typedef typename Graph::Weight Weight;
+    typedef WeightTraits<Weight> Traits;
+
+    static void run(const Graph &graph, int source, PathTree<Weight> &tree) {
+        tree.distance.assign(graph.size(), Traits::infinity());
+        tree.parent.assign(graph.size(), -1);
+        tree.parentEdge.assign(graph.size(), -1);
+        tree.order.clear();
+        if (source < 0 || source >= graph.size()) return;
+
+        if constexpr (Traits::IS_INTEGER) {
+            if (graph.getMaxWeight() <= DIAL_MAX_WEIGHT) {
+                runDial(graph, source, tree);
+                return;
+            }
+        }
+        runHeap(graph, source, tree);
+    }
+
+    // The same search on the calling thread's workspace, for callers that
+    // answer many: nothing is allocated or refilled per run. Distances and
+    // parents count for reached vertices, and order lists them as settled.
+    // Always uses the heap
+    static QueryWorkspace<Weight>& run(const Graph &graph, int source) {
+        return run(graph, source, QueryWorkspace<Weight>::local(graph.size()));
+    }
+
+    // As above on a workspace of the caller's, begun for the graph's size
+    static QueryWorkspace<Weight>& run(const Graph &graph, int source, QueryWorkspace<Weight> &workspace) {
+        if (source < 0 || source >= graph.size()) return workspace;
+
+        workspace.reach(source, 0, -1, -1);
+        workspace.push(0, source);
+
+        while (!workspace.heap.empty()) {
+            auto [distance, vertex] = workspace.pop();
+            // Entries are only pushed for a strictly shorter distance, so
+            // exactly one per vertex matches it
+            if (distance > workspace.distance[vertex]) continue;
+
+            workspace.order.push_back(vertex);
+            graph.forEachOut(vertex, [&](int target, Weight weight, int edgeId) {
+                Weight candidate = distance + weight;
+                if (candidate < workspace.distanceTo(target)) {
+                    workspace.reach(target, candidate, vertex, edgeId);
+                    workspace.push(candidate, target);
+                }
+            });
+        }
+        return workspace;
+    }
+
+    static constexpr uint32_t DIAL_MAX_WEIGHT = 1 << 16;
+
+private:
+    static void runHeap(const Graph &graph, int source, PathTree<Weight> &tree) {
+        typedef std::pair<Weight, int> Entry;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+        std::vector<bool> settled(graph.size(), false);
+
+        tree.distance[source] = 0;
+        queue.push({0, source});
+
+        while (!queue.empty()) {
+            auto [distance, vertex] = queue.top();
+            queue.pop();
+            if (settled[vertex]) continue;
+
+            settled[vertex] = true;
+            tree.order.push_back(vertex);
+
+            graph.forEachOut(vertex, [&](int target, Weight weight, int edgeId) {
+                Weight candidate = distance + weight;
+                if (candidate < tree.distance[target]) {
+                    tree.distance[target] = candidate;
+                    tree.parent[target] = vertex;
+                    tree.parentEdge[target] = edgeId;
+                    queue.push({candidate, target});
+                }
+            });
+        }
+    }
+
+    // Tentative distances never exceed the current one by more than the
+    // heaviest edge, so maxWeight + 1 buckets used as a ring hold them all
+    static void runDial(const Graph &graph, int source, PathTree<Weight> &tree) {
+        const size_t ringSize = size_t(graph.getMaxWeight()) + 1;
+        std::vector<std::vector<int>> buckets(ringSize);
+        std::vector<bool> settled(graph.size(), false);
+
+        tree.distance[source] = 0;
+        buckets[0].push_back(source);
+        size_t pending = 1;
+
+        for (Weight distance = 0; pending > 0; ++distance) {
+            std::vector<int>& bucket = buckets[distance % ringSize];
+
+            // Zero-weight edges append to the bucket being scanned
+            for (size_t i = 0; i < bucket.size(); ++i) {
+                int vertex = bucket[i];
+                if (settled[vertex] || tree.distance[vertex] != distance) continue;
+
+                settled[vertex] = true;
+                tree.order.push_back(vertex);
+
+                graph.forEachOut(vertex, [&](int target, Weight weight, int edgeId) {
+                    Weight candidate = distance + weight;
+                    if (candidate < tree.distance[target]) {
+                        tree.distance[target] = candidate;
+                        tree.parent[target] = vertex;
+                        tree.parentEdge[target] = edgeId;
+                        buckets[candidate % ringSize].push_back(target);
+                        ++pending;
+                    }
+                });
+            }
+
+            pending -= bucket.size();
+            bucket.clear();
+        }
+    }
+};
+
+#endif // SHORTESTPATH_H
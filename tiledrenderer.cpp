@@ -0,0 +1,68 @@
+#include "tiledrenderer.h"
+#include "memoryreport.h"
+#include "parallel.h"
+#include "trace.h"
+
+#include <algorithm>
+
+size_t TiledRenderer::memoryUsage() const {
+    size_t bytes = MemoryReport::vectorBytes(tiles);
+    for (const QImage& tile : tiles) {
+        bytes += MemoryReport::heapBytes(tile.sizeInBytes());
+    }
+    return bytes;
+}
+
+void TiledRenderer::render(QPainter &painter, const std::vector<const DrawBatch*> &layers, const LabelCache &labels,
+                           const QSize &viewport, qreal devicePixelRatio, const QPointF &offset, qreal scaleFactor) {
+    const int columns = (viewport.width() + TILE_SIZE - 1) / TILE_SIZE;
+    const int rows = (viewport.height() + TILE_SIZE - 1) / TILE_SIZE;
+    if (columns <= 0 || rows <= 0) return;
+
+    tiles.resize(size_t(columns) * rows);
+
+    // Fonts share engine caches between copies, so every tile parses its own
+    const QString regularFont = labels.getFont(false).toString();
+    const QString italicFont = labels.getFont(true).toString();
+
+    parallel::forEach(tiles.size(), [&](size_t index) {
+        TRACE_SCOPE("TiledRenderer::tile");
+
+        QPoint origin(index % columns * TILE_SIZE, index / columns * TILE_SIZE);
+        QSize size(std::min(TILE_SIZE, viewport.width() - origin.x()), std::min(TILE_SIZE, viewport.height() - origin.y()));
+
+        QImage& tile = tiles[index];
+        if (tile.size() != size * devicePixelRatio) {
+            tile = QImage(size * devicePixelRatio, QImage::Format_ARGB32_Premultiplied);
+            tile.setDevicePixelRatio(devicePixelRatio);
+        }
+        tile.fill(Qt::transparent);
+
+        QFont regular;
+        regular.fromString(regularFont);
+        QFont italic;
+        italic.fromString(italicFont);
+
+        // Tile bounds in scene coordinates, widened for pen widths and antialiasing
+        qreal margin = CLIP_MARGIN / scaleFactor + CLIP_MARGIN;
+        QRectF clip((origin.x() - offset.x()) / scaleFactor - margin, (origin.y() - offset.y()) / scaleFactor - margin,
+                    size.width() / scaleFactor + 2 * margin, size.height() / scaleFactor + 2 * margin);
+
+        QPainter tilePainter(&tile);
+        tilePainter.setRenderHint(QPainter::Antialiasing);
+        tilePainter.translate(offset - QPointF(origin));
+        tilePainter.scale(scaleFactor, scaleFactor);
+
+        for (const DrawBatch *layer : layers) {
+            layer->draw(tilePainter, regular, italic, clip, false);
+        }
+    });
+
+    painter.save();
+    painter.resetTransform();
+    painter.setOpacity(1);
+    for (size_t index = 0; index < tiles.size(); ++index) {
+        painter.drawImage(QPoint(index % columns * TILE_SIZE, index / columns * TILE_SIZE), tiles[index]);
+    }
+    painter.restore();
+}
@@ -0,0 +1,28 @@
+#ifndef TILEDRENDERER_H
+#define TILEDRENDERER_H
+
+#include "drawbatch.h"
+
+#include <vector>
+
+#include <QImage>
+
+// Rasterises collected draw batches on all cores. The viewport is split into
+// tiles, every tile is painted into its own image on a worker thread with
+// only the items that touch it, and the tiles are composited in order.
+class TiledRenderer {
+
+public:
+    void render(QPainter &painter, const std::vector<const DrawBatch*> &layers, const LabelCache &labels,
+                const QSize &viewport, qreal devicePixelRatio, const QPointF &offset, qreal scaleFactor);
+    size_t tileCount() const { return tiles.size(); }
+    size_t memoryUsage() const;
+
+    static constexpr int TILE_SIZE = 256;
+    static constexpr qreal CLIP_MARGIN = 2;
+
+private:
+    std::vector<QImage> tiles;
+};
+
+#endif // TILEDRENDERER_H
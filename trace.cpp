@@ -0,0 +1,159 @@
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+namespace {
+    struct TraceEvent {
+        const char *name;
+        uint64_t startNs;
+        uint64_t durationNs;
+        uint32_t threadId;
+    };
+
+    // Sequence is the event index + 1 once the slot is complete and 0 while
+    // it is being written, so a reader can tell a torn copy (seqlock)
+    struct TraceSlot {
+        std::atomic<uint64_t> sequence{0};
+        std::atomic<const char*> name{nullptr};
+        std::atomic<uint64_t> startNs{0};
+        std::atomic<uint64_t> durationNs{0};
+    };
+
+    constexpr uint64_t BUFFER_CAPACITY = 1 << 14;
+
+    // Single-producer ring. Only the owning thread writes the slots; dump()
+    // keeps the copies whose sequence did not change while reading them.
+    // threadId and first only change under retiredMutex.
+    struct ThreadBuffer {
+        std::atomic<bool> inUse{true};
+        std::atomic<uint64_t> head{0};
+        uint64_t first = 0;
+        uint32_t threadId;
+        ThreadBuffer *next = nullptr;
+        TraceSlot slots[BUFFER_CAPACITY];
+    };
+
+    std::atomic<ThreadBuffer*> buffers{nullptr};
+    std::atomic<uint32_t> nextThreadId{1};
+    std::atomic<uint64_t> recordingStart{0};
+
+    // Events of finished threads whose buffers were handed to new ones
+    std::mutex retiredMutex;
+    std::vector<TraceEvent> retired;
+
+    const auto epoch = std::chrono::steady_clock::now();
+
+    // Appends the complete events of buffer recorded since the start
+    void copyEvents(const ThreadBuffer *buffer, uint64_t since, std::vector<TraceEvent> &events) {
+        uint64_t head = buffer->head.load(std::memory_order_acquire);
+        uint64_t first = std::max(buffer->first, head > BUFFER_CAPACITY ? head - BUFFER_CAPACITY : 0);
+
+        for (uint64_t i = first; i < head; ++i) {
+            const TraceSlot &slot = buffer->slots[i % BUFFER_CAPACITY];
+            uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+            TraceEvent event = {slot.name.load(std::memory_order_relaxed), slot.startNs.load(std::memory_order_relaxed),
+                                slot.durationNs.load(std::memory_order_relaxed), buffer->threadId};
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (sequence != i + 1 || slot.sequence.load(std::memory_order_relaxed) != sequence) continue;
+            if (event.startNs >= since) events.push_back(event);
+        }
+    }
+
+    ThreadBuffer* claimBuffer() {
+        // Reuse a buffer released by a finished thread before allocating. Its
+        // events keep the old thread id, the new thread starts at the head
+        for (ThreadBuffer *buffer = buffers.load(std::memory_order_acquire); buffer; buffer = buffer->next) {
+            bool expected = false;
+            if (buffer->inUse.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+                std::lock_guard<std::mutex> lock(retiredMutex);
+                if (Trace::isEnabled()) copyEvents(buffer, recordingStart.load(std::memory_order_relaxed), retired);
+                buffer->first = buffer->head.load(std::memory_order_relaxed);
+                buffer->threadId = nextThreadId++;
+                return buffer;
+            }
+        }
+
+        ThreadBuffer *buffer = new ThreadBuffer();
+        buffer->threadId = nextThreadId++;
+        buffer->next = buffers.load(std::memory_order_relaxed);
+        while (!buffers.compare_exchange_weak(buffer->next, buffer, std::memory_order_release, std::memory_order_relaxed)) {}
+        return buffer;
+    }
+
+    struct BufferOwner {
+        ThreadBuffer *buffer = nullptr;
+
+        ~BufferOwner() {
+            if (buffer) buffer->inUse.store(false, std::memory_order_release);
+        }
+    };
+
+    thread_local BufferOwner owner;
+}
+
+std::atomic<bool> Trace::enabled{false};
+
+uint64_t Trace::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void Trace::start() {
+    {
+        std::lock_guard<std::mutex> lock(retiredMutex);
+        retired.clear();
+    }
+    recordingStart.store(now(), std::memory_order_relaxed);
+    enabled.store(true, std::memory_order_relaxed);
+}
+
+void Trace::stop() {
+    enabled.store(false, std::memory_order_relaxed);
+}
+
+void Trace::record(const char *name, uint64_t startNs, uint64_t endNs) {
+    if (!owner.buffer) owner.buffer = claimBuffer();
+
+    ThreadBuffer *buffer = owner.buffer;
+    uint64_t head = buffer->head.load(std::memory_order_relaxed);
+    TraceSlot &slot = buffer->slots[head % BUFFER_CAPACITY];
+
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.startNs.store(startNs, std::memory_order_relaxed);
+    slot.durationNs.store(endNs - startNs, std::memory_order_relaxed);
+    slot.sequence.store(head + 1, std::memory_order_release);
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+bool Trace::dump(const std::string &path) {
+    std::ofstream out(path);
+    if (!out) return false;
+
+    uint64_t since = recordingStart.load(std::memory_order_relaxed);
+    std::vector<TraceEvent> events;
+    {
+        std::lock_guard<std::mutex> lock(retiredMutex);
+        events = retired;
+        for (ThreadBuffer *buffer = buffers.load(std::memory_order_acquire); buffer; buffer = buffer->next) {
+            copyEvents(buffer, since, events);
+        }
+    }
+
+    out << "{\"traceEvents\":[";
+    for (size_t i = 0; i < events.size(); ++i) {
+        const TraceEvent &event = events[i];
+        out << (i ? "," : "") << "\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1"
+            << ",\"tid\":" << event.threadId
+            << ",\"ts\":" << event.startNs / 1000.0
+            << ",\"dur\":" << event.durationNs / 1000.0 << "}";
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+    return bool(out);
+}
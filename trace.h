@@ -0,0 +1,49 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Scoped trace events recorded into per-thread ring buffers and dumped as
+// Chrome trace JSON (chrome://tracing, ui.perfetto.dev). Names must be
+// string literals; a disabled scope costs one relaxed atomic load.
+class Trace {
+
+public:
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+    static void start();
+    static void stop();
+    static bool dump(const std::string &path);
+
+    static uint64_t now();
+    static void record(const char *name, uint64_t startNs, uint64_t endNs);
+
+private:
+    static std::atomic<bool> enabled;
+};
+
+class TraceScope {
+
+public:
+    TraceScope(const char *name) : name(Trace::isEnabled() ? name : nullptr) {
+        if (this->name) startNs = Trace::now();
+    }
+
+    ~TraceScope() {
+        if (name) Trace::record(name, startNs, Trace::now());
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char *name;
+    uint64_t startNs = 0;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+
+#endif // TRACE_H
@@ -1,60 +1,84 @@
-#include "utils.h"
-#include "vertex.h"
-#include "canvas.h"
-
-#include <QPainter>
-
-Vertex::Vertex(QString displayName, int id, int radius, QPointF& pos, QWidget* parent)
-    : displayName(displayName), id(id), radius(radius), pos(pos) {
-    weight = UNDEFINED;
-}
-
-void Vertex::draw(Canvas *canvas, QPainter& painter) {
-    qreal distToCenter = QLineF{canvas->getScreenCenter(), pos}.length();
-    if (distToCenter - radius - LINE_THICKNESS > canvas->getHalfScreenDiagonal()) {
-        return;
-    }
-
-    if (isSelected) {
-        painter.setPen(Qt::green);
-    }
-
-    if (weight > -2) {
-        if (canvas->djEndAnimation.find(id) != canvas->djEndAnimation.end()) {
-            painter.setBrush(dEndAnimColor);
-        }
-        else if (id == canvas->djEndVertex) {
-            painter.setBrush(dEndColor);
-        }
-        else if (id == canvas->djCurrentVertex) {
-            painter.setBrush(dCurrColor);
-        }
-        else if (id == canvas->djStartVertex) {
-            painter.setBrush(dFirstColor);
-        }
-        else if (utils::contains(canvas->djCheckedVertices, id)) {
-            painter.setBrush(dChekcedColor);
-        }
-    }
-
-    painter.drawEllipse(pos, radius, radius);
-    painter.setPen(Qt::black);
-    painter.setBrush(Qt::white);
-    canvas->font.setItalic(false);
-    painter.setFont(canvas->font);
-
-    QPointF textPos = pos + utils::getTextCenterAlign(painter.fontMetrics(), displayName);
-
-    painter.drawText(textPos, displayName);
-
-    if (weight > -2) {
-        painter.setPen(dWeightColor);
-        QFont weightFont = canvas->font;
-        weightFont.setItalic(true);
-        painter.setFont(weightFont);
-
-        QString weightText = weight == INF ? "∞" : QString::number(weight);
-        painter.drawText(pos + WEIGHT_TEXT_OFFSET + utils::getTextCenterAlign(painter.fontMetrics(), weightText), weightText);
-        painter.setPen(Qt::black);
-    }
-}
+#include "utils.h"
+#include "vertex.h"
+#include "canvas.h"
+
+#include <QPainter>
+
+Vertex::Vertex(QString displayName, int id, int radius, QPointF& pos, QWidget* parent)
+    : displayName(displayName), id(id), radius(radius), pos(pos), weight(UNDEFINED) {
+}
+
+void Vertex::setWeight(qreal value, int epoch) {
+    weight = value;
+    weightText = weight == INF ? "∞" : QString::number(weight);
+    weightEpoch = epoch;
+}
+
+// Weights from before the canvas last cleared them are stale
+bool Vertex::hasWeight(const Canvas *canvas) const {
+    return weightEpoch == canvas->weightEpoch;
+}
+
+QRectF Vertex::bounds(Canvas *canvas) {
+    qreal extent = radius + LINE_THICKNESS;
+    QRectF rect(pos.x() - extent, pos.y() - extent, 2 * extent, 2 * extent);
+
+    auto labelRect = [](const QPointF& center, const LabelCache::Label& label) {
+        QPointF textPos = center + label.centerOffset;
+        return QRectF(textPos.x(), textPos.y() - label.ascent, -2 * label.centerOffset.x(), 2 * label.ascent);
+    };
+
+    rect = rect.united(labelRect(pos, canvas->labels.get(displayName)));
+    if (hasWeight(canvas)) {
+        rect = rect.united(labelRect(pos + WEIGHT_TEXT_OFFSET, canvas->labels.get(weightText, true)));
+    }
+
+    return rect.adjusted(-LINE_THICKNESS, -LINE_THICKNESS, LINE_THICKNESS, LINE_THICKNESS);
+}
+
+void Vertex::draw(Canvas *canvas, DrawBatch& batch) {
+    qreal distToCenter = QLineF{canvas->getScreenCenter(), pos}.length();
+    bool isCulled = distToCenter - radius - LINE_THICKNESS > canvas->getHalfScreenDiagonal();
+    if (!isCulled && canvas->isPartialPaint) {
+        isCulled = !canvas->paintBounds.intersects(bounds(canvas));
+    }
+
+    if (isCulled) {
+        canvas->profiler.countVertex(false);
+        return;
+    }
+    canvas->profiler.countVertex(true);
+
+    DrawBatch::Style style = {isSelected ? Qt::green : Qt::black, Qt::white};
+
+    bool isWeighted = hasWeight(canvas);
+    if (isWeighted) {
+        if (canvas->djEndAnimation.find(id) != canvas->djEndAnimation.end()) {
+            style.brush = dEndAnimColor;
+        }
+        else if (id == canvas->djEndVertex) {
+            style.brush = dEndColor;
+        }
+        else if (id == canvas->djCurrentVertex) {
+            style.brush = dCurrColor;
+        }
+        else if (id == canvas->djStartVertex) {
+            style.brush = dFirstColor;
+        }
+        else if (canvas->djCheckedVertices.count(id)) {
+            style.brush = dChekcedColor;
+        }
+    }
+
+    batch.addEllipse(style, pos, radius);
+
+    const LabelCache::Label& name = canvas->labels.get(displayName);
+    batch.addText(Qt::black, false, pos + name.centerOffset, name);
+    canvas->profiler.countText();
+
+    if (isWeighted) {
+        const LabelCache::Label& weightLabel = canvas->labels.get(weightText, true);
+        batch.addText(dWeightColor, true, pos + WEIGHT_TEXT_OFFSET + weightLabel.centerOffset, weightLabel);
+        canvas->profiler.countText();
+    }
+}
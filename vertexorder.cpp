@@ -0,0 +1,129 @@
+#include "vertexorder.h"
+#include "trace.h"
+
+#include <algorithm>
+
+const char* VertexOrder::name(Method method) {
+    switch (method) {
+    case CUTHILL_MCKEE: return "cuthill-mckee";
+    case HILBERT: return "hilbert";
+    default: return "snapshot";
+    }
+}
+
+std::vector<int> VertexOrder::compute(const GraphSnapshot &graph, Method method) {
+    TRACE_SCOPE("VertexOrder::compute");
+
+    if (method == CUTHILL_MCKEE) return cuthillMcKee(graph);
+    if (method == HILBERT) return hilbert(graph);
+
+    std::vector<int> ids;
+    ids.reserve(graph.vertexCount());
+    graph.forEachVertex([&](const VertexRecord &vertex) {
+        ids.push_back(vertex.id);
+    });
+    return ids;
+}
+
+// Reverse Cuthill-McKee over the undirected graph: breadth-first from a
+// low-degree vertex of each component, neighbours taken by increasing degree
+std::vector<int> VertexOrder::cuthillMcKee(const GraphSnapshot &graph) {
+    std::vector<int> degree(graph.vertexIdBound(), -1);
+    std::vector<int> starts;
+    starts.reserve(graph.vertexCount());
+    graph.forEachVertex([&](const VertexRecord &vertex) {
+        degree[vertex.id] = vertex.in.vertexId.size() + vertex.out.vertexId.size();
+        starts.push_back(vertex.id);
+    });
+
+    std::stable_sort(starts.begin(), starts.end(), [&](int a, int b) { return degree[a] < degree[b]; });
+
+    std::vector<bool> visited(graph.vertexIdBound(), false);
+    std::vector<int> order;
+    std::vector<int> neighbours;
+    order.reserve(graph.vertexCount());
+
+    for (int startId : starts) {
+        if (visited[startId]) continue;
+
+        visited[startId] = true;
+        order.push_back(startId);
+
+        for (size_t head = order.size() - 1; head < order.size(); ++head) {
+            const VertexRecord *vertex = graph.vertex(order[head]);
+
+            neighbours.clear();
+            for (const std::vector<int> *list : {&vertex->out.vertexId, &vertex->in.vertexId}) {
+                for (int id : *list) {
+                    if (visited[id]) continue;
+
+                    visited[id] = true;
+                    neighbours.push_back(id);
+                }
+            }
+
+            std::sort(neighbours.begin(), neighbours.end(), [&](int a, int b) {
+                return degree[a] != degree[b] ? degree[a] < degree[b] : a < b;
+            });
+            order.insert(order.end(), neighbours.begin(), neighbours.end());
+        }
+    }
+
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+// Vertices sorted along a Hilbert curve through their canvas positions
+std::vector<int> VertexOrder::hilbert(const GraphSnapshot &graph) {
+    std::vector<std::pair<uint64_t, int>> keys;
+    keys.reserve(graph.vertexCount());
+
+    QPointF min, max;
+    bool isFirst = true;
+    graph.forEachVertex([&](const VertexRecord &vertex) {
+        if (isFirst) min = max = vertex.pos;
+        isFirst = false;
+        min = {std::min(min.x(), vertex.pos.x()), std::min(min.y(), vertex.pos.y())};
+        max = {std::max(max.x(), vertex.pos.x()), std::max(max.y(), vertex.pos.y())};
+    });
+
+    const qreal cells = (1 << HILBERT_BITS) - 1;
+    qreal extent = std::max(max.x() - min.x(), max.y() - min.y());
+    qreal scale = extent > 0 ? cells / extent : 0;
+
+    graph.forEachVertex([&](const VertexRecord &vertex) {
+        uint32_t x = (vertex.pos.x() - min.x()) * scale;
+        uint32_t y = (vertex.pos.y() - min.y()) * scale;
+        keys.push_back({hilbertIndex(x, y), vertex.id});
+    });
+
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<int> order;
+    order.reserve(keys.size());
+    for (const auto& [key, id] : keys) {
+        order.push_back(id);
+    }
+    return order;
+}
+
+uint64_t VertexOrder::hilbertIndex(uint32_t x, uint32_t y) {
+    uint64_t index = 0;
+
+    for (uint32_t half = 1u << (HILBERT_BITS - 1); half > 0; half >>= 1) {
+        uint32_t rx = (x & half) ? 1 : 0;
+        uint32_t ry = (y & half) ? 1 : 0;
+        index += uint64_t(half) * half * ((3 * rx) ^ ry);
+
+        // Rotate the quadrant so the curve stays continuous
+        if (ry == 0) {
+            if (rx == 1) {
+                x = half - 1 - (x & (half - 1));
+                y = half - 1 - (y & (half - 1));
+            }
+            std::swap(x, y);
+        }
+    }
+
+    return index;
+}
@@ -0,0 +1,34 @@
+#ifndef VERTEXORDER_H
+#define VERTEXORDER_H
+
+#include "graphsnapshot.h"
+
+#include <cstdint>
+#include <vector>
+
+// Renumbering of the vertices for the flat algorithm graphs. Canvas ids
+// follow click or import order, so neighbours end up far apart in the flat
+// arrays; both orders below place connected or nearby vertices close
+// together to cut cache misses during traversal.
+class VertexOrder {
+
+public:
+    enum Method {
+        SNAPSHOT,
+        CUTHILL_MCKEE,
+        HILBERT
+    };
+
+    // Vertex ids in their new order; position i is the flat index of ids[i]
+    static std::vector<int> compute(const GraphSnapshot &graph, Method method);
+    static const char* name(Method method);
+
+    static constexpr int HILBERT_BITS = 16;
+
+private:
+    static std::vector<int> cuthillMcKee(const GraphSnapshot &graph);
+    static std::vector<int> hilbert(const GraphSnapshot &graph);
+    static uint64_t hilbertIndex(uint32_t x, uint32_t y);
+};
+
+#endif // VERTEXORDER_H